@@ -1,10 +1,13 @@
 #version 430 core
 
 layout (location = 0) in vec2 textureCoordsIn;
+layout (location = 1) flat in int paletteIdxIn;
+layout (location = 2) flat in int atlasPageIn;
 layout (location = 0) out vec4 fragColor;
-layout (location = 0) uniform sampler2D textureAtlas;
+layout (binding = 0) uniform usampler2DArray textureAtlas;
+layout (binding = 1) uniform sampler2D palette;
 
 void main(){
-    vec4 textureColor = texelFetch(textureAtlas, ivec2(textureCoordsIn), 0);
-    fragColor = textureColor;
+    uint colorIdx = texelFetch(textureAtlas, ivec3(textureCoordsIn, atlasPageIn), 0).r;
+    fragColor = texelFetch(palette, ivec2(colorIdx, paletteIdxIn), 0);
 }
\ No newline at end of file
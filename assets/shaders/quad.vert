@@ -5,17 +5,24 @@ struct Transform {
     vec2 size;
     ivec2 atlasOffset;
     ivec2 spriteSize;
+    int paletteIdx;
+    int atlasPage;
 };
 
 layout (std430, binding = 0) buffer TransformSBO {  Transform transforms[]; };
 
-uniform vec2 screenSize;
-uniform mat4 orthoProjection;
+layout (std140, binding = 0) uniform RenderPassUBO {
+    mat4 orthoProjection;
+    vec2 screenSize;
+    int instanceOffset;
+};
 
 layout (location = 0) out vec2 textureCoordsOut;
+layout (location = 1) flat out int paletteIdxOut;
+layout (location = 2) flat out int atlasPageOut;
 
 void main(){
-    Transform transform = transforms[gl_InstanceID];
+    Transform transform = transforms[instanceOffset + gl_InstanceID];
 
     vec2 vertices [6] = {
         transform.pos, 
@@ -41,4 +48,6 @@ void main(){
         gl_Position = orthoProjection * vec4(vertexPos, 0.0, 1.0);
     }
     textureCoordsOut = textureCoords[gl_VertexID];
+    paletteIdxOut = transform.paletteIdx;
+    atlasPageOut = transform.atlasPage;
 }
\ No newline at end of file
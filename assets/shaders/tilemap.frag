@@ -0,0 +1,31 @@
+#version 430 core
+
+layout (std140, binding = 1) uniform TilemapUBO {
+    vec2 viewMin;
+    vec2 viewSize;
+    vec2 screenSize;
+    ivec2 sizeInTiles;
+    int tileSize;
+    int paletteIdx;
+    int atlasPage;
+    ivec4 atlasOffsets[21];
+};
+
+layout (location = 0) out vec4 fragColor;
+layout (binding = 0) uniform usampler2DArray textureAtlas;
+layout (binding = 1) uniform sampler2D palette;
+layout (binding = 3) uniform usampler2D tileIndices;
+
+void main(){
+    // gl_FragCoord counts rows from the bottom, the view from the top
+    vec2 screenPos = vec2(gl_FragCoord.x, screenSize.y - gl_FragCoord.y);
+    ivec2 worldPos = ivec2(floor(viewMin + screenPos * viewSize / screenSize));
+    ivec2 tilePos = ivec2(floor(vec2(worldPos) / float(tileSize)));
+    if(any(lessThan(tilePos, ivec2(0))) || any(greaterThanEqual(tilePos, sizeInTiles))) discard;
+
+    uint tileIdx = texelFetch(tileIndices, tilePos & (textureSize(tileIndices, 0) - 1), 0).r;
+    if(tileIdx == 0u) discard;
+    ivec2 textureCoords = atlasOffsets[tileIdx - 1u].xy + worldPos - tilePos * tileSize;
+    uint colorIdx = texelFetch(textureAtlas, ivec3(textureCoords, atlasPage), 0).r;
+    fragColor = texelFetch(palette, ivec2(colorIdx, paletteIdx), 0);
+}
\ No newline at end of file
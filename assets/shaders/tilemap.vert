@@ -0,0 +1,7 @@
+#version 430 core
+
+// One triangle that covers the whole render target, the fragment shader looks up the tile under every pixel
+void main(){
+    vec2 vertices[3] = {vec2(-1.0, -1.0), vec2(3.0, -1.0), vec2(-1.0, 3.0)};
+    gl_Position = vec4(vertices[gl_VertexID], 0.0, 1.0);
+}
\ No newline at end of file
@@ -6,7 +6,24 @@ libs="-luser32 -lopengl32 -lgdi32"
 warnings="-Wno-writable-strings -Wno-format-security -Wno-deprecated-declarations -Wno-switch"
 includes="-Ithird_party -Ithird_party/Include"
 
+# Sprite and animation tables come from the slices and tags of the atlas. A failing tool stops the build, everything
+# after it would compile against the last headers it wrote
+clang++ $includes -O2 tools/aseprite_import.cpp -oaseprite_import.exe $warnings || exit 1
+./aseprite_import.exe assets/textures/Texture_Atlas.aseprite src/assets_generated.h || exit 1
+
+# Loose images are packed onto the atlas pages that follow the aseprite one, an empty sprites folder packs none
+shopt -s nullglob
+clang++ $includes -O2 tools/atlas_pack.cpp -oatlas_pack.exe $warnings || exit 1
+./atlas_pack.exe src/atlas_generated.h assets/textures/Atlas_Page_ 256 assets/textures/Texture_Atlas.png assets/textures/sprites/*.png || exit 1
+shopt -u nullglob
+
+# Pixel collision masks are baked from the alpha of the finished atlas pages
+clang++ $includes -O2 tools/collision_bake.cpp -ocollision_bake.exe $warnings || exit 1
+./collision_bake.exe src/collision_generated.h || exit 1
+
 clang++ $includes -g src/main.cpp -oengine.exe $libs $warnings
+clang++ $includes -O2 src/bench.cpp -obench.exe $warnings
+clang++ $includes -O2 src/headless_main.cpp -oheadless.exe $warnings
 
 rm -f game_*
 clang++ -g "src/game.cpp" -shared -o game_$timestamp.dll $warnings
@@ -0,0 +1,82 @@
+#pragma once
+#include "engine_lib.h"
+#include "assets.h"
+#include "render_interface.h"
+
+//#####################################################################################################################################
+//                                                  Animation Structs
+//#####################################################################################################################################
+// Playback state of one animated sprite, kept by whoever owns the sprite and advanced in batches
+struct AnimationState{
+    AnimationID animationID;
+    float time;                 // seconds, looping animations wrap, the others stop at their duration
+};
+
+//#####################################################################################################################################
+//                                                  Animation Functions
+//#####################################################################################################################################
+AnimationState make_animation_state(AnimationID animationID){
+    SM_ASSERT(animationID >= 0 && animationID < ANIMATION_COUNT, "Invalid AnimationID %d", animationID);
+    return {animationID, 0.0f};
+}
+
+// Both outcomes are computed and selected, nothing in the loop depends on which animation is playing
+void update_animations(AnimationState* states, int count, float dt){
+    for(int idx = 0; idx < count; idx++){
+        Animation animation = ANIMATIONS[states[idx].animationID];
+        float time = states[idx].time + dt;
+        float wrapped = time - floorf(time / animation.duration) * animation.duration;
+        float held = time < animation.duration ? time : animation.duration;
+        states[idx].time = animation.loop ? wrapped : held;
+    }
+}
+
+// Index into ANIMATION_FRAMES of the frame shown at state.time
+int get_animation_frame_index(AnimationState state){
+    Animation animation = ANIMATIONS[state.animationID];
+    int tick = (int)(state.time * animation.ticksPerSecond);
+    tick = tick < animation.tickCount - 1 ? tick : animation.tickCount - 1;
+    return ANIMATION_TICKS[animation.firstTick + tick];
+}
+
+AnimationFrame get_animation_frame(AnimationState state){
+    return ANIMATION_FRAMES[get_animation_frame_index(state)];
+}
+
+// Centered on pos like draw_sprite
+void draw_animation(AnimationState state, Vec2 pos){
+    AnimationFrame frame = get_animation_frame(state);
+    Transform transform = {};
+    transform.size = vec_2(frame.spriteSize);
+    transform.pos = pos - vec_2(frame.spriteSize) / 2.0f;
+    transform.atlasOffset = frame.atlasOffset;
+    transform.spriteSize = frame.spriteSize;
+    transform.paletteIdx = renderData->currentPalette;
+    transform.atlasPage = frame.atlasPage;
+    draw_quad(transform);
+}
+
+void draw_animation(AnimationState state, IVec2 pos){
+    draw_animation(state, vec_2(pos));
+}
+
+// Same as draw_sprites with a frame looked up per instance
+void draw_animations(const AnimationState* states, const IVec2* positions, int count){
+    ViewRect view = get_camera_view(get_pass_camera(renderData->currentPass));
+    TransformSpan span = reserve_transforms(count);
+    Transform* transforms = span.elements;
+    int usedCount = 0;
+    for(int idx = 0; idx < span.count; idx++){
+        AnimationFrame frame = get_animation_frame(states[idx]);
+        Vec2 size = vec_2(frame.spriteSize);
+        Vec2 pos = {positions[idx].x - size.x / 2.0f, positions[idx].y - size.y / 2.0f};
+        transforms[usedCount].pos = pos;
+        transforms[usedCount].size = size;
+        transforms[usedCount].atlasOffset = frame.atlasOffset;
+        transforms[usedCount].spriteSize = frame.spriteSize;
+        transforms[usedCount].paletteIdx = renderData->currentPalette;
+        transforms[usedCount].atlasPage = frame.atlasPage;
+        usedCount += is_visible(view, pos, size);
+    }
+    trim_transforms(span, usedCount);
+}
@@ -7,34 +7,75 @@
 //#####################################################################################################################################
 //                                                  Assets Structs
 //#####################################################################################################################################
-enum SpriteID{
-    SPRITE_WHITE,
-    SPRITE_DICE,
+// Rows of the palette texture, every one is derived from the colors the atlas was painted with
+enum PaletteID{
+    PALETTE_DEFAULT,
+    PALETTE_REWIND,
 
-    SPRITE_COUNT
+    PALETTE_COUNT
 };
 
 struct Sprite{
     IVec2 atlasOffset;
     IVec2 spriteSize;
+    int atlasPage;              // index into ATLAS_PAGES, the aseprite atlas is page 0
 };
+
+struct AnimationFrame{
+    IVec2 atlasOffset;
+    IVec2 spriteSize;
+    int atlasPage;
+};
+
+// ANIMATION_TICKS[firstTick + n] is the ANIMATION_FRAMES index shown during tick n of the animation
+struct Animation{
+    int firstTick;
+    int tickCount;
+    float ticksPerSecond;
+    float duration;             // seconds, tickCount / ticksPerSecond
+    bool loop;                  // otherwise the last frame is held
+};
+
+// SpriteID, AnimationID and their tables, written by tools/aseprite_import.cpp from the slices and tags of
+// assets/textures/Texture_Atlas.aseprite
+#include "assets_generated.h"
+// ATLAS_PAGES, PackedSpriteID and PACKED_SPRITES, written by tools/atlas_pack.cpp from assets/textures/sprites
+#include "atlas_generated.h"
+
 //#####################################################################################################################################
 //                                                  Assets Functions
 //#####################################################################################################################################
 Sprite get_sprite(SpriteID spriteID){
-    Sprite sprite = {};
-    switch (spriteID)
-    {
-        case SPRITE_WHITE:{
-            sprite.atlasOffset = {0, 0};
-            sprite.spriteSize = {1, 1};
-            break;
-        }
-        case SPRITE_DICE:{
-            sprite.atlasOffset = {16, 0};
-            sprite.spriteSize = {16, 16};
-            break;
+    SM_ASSERT(spriteID >= 0 && spriteID < SPRITE_COUNT, "Invalid SpriteID %d", spriteID);
+    return SPRITES[spriteID];
+}
+
+Sprite get_sprite(PackedSpriteID spriteID){
+    SM_ASSERT(spriteID >= 0 && spriteID < PACKED_SPRITE_COUNT, "Invalid PackedSpriteID %d", spriteID);
+    return PACKED_SPRITES[spriteID];
+}
+
+// Newest change to any page, the atlas is reloaded as a whole
+long long get_atlas_timestamp(){
+    long long timestamp = 0;
+    for(int pageIdx = 0; pageIdx < ATLAS_PAGE_COUNT; pageIdx++){
+        timestamp = max(timestamp, get_timestamp(ATLAS_PAGES[pageIdx]));
+    }
+    return timestamp;
+}
+
+// color is RGBA8 sRGB with R in the lowest byte
+unsigned int get_palette_color(PaletteID paletteID, unsigned int color){
+    switch(paletteID){
+        case PALETTE_REWIND:{
+            // Sepia, alpha is kept
+            float r = (color & 0xFF), g = (color >> 8 & 0xFF), b = (color >> 16 & 0xFF);
+            float luma = 0.30f * r + 0.59f * g + 0.11f * b;
+            unsigned int sepiaR = (unsigned int)min(luma * 1.07f, 255.0f);
+            unsigned int sepiaG = (unsigned int)min(luma * 0.74f, 255.0f);
+            unsigned int sepiaB = (unsigned int)min(luma * 0.43f, 255.0f);
+            return sepiaR | sepiaG << 8 | sepiaB << 16 | (color & 0xFF000000);
         }
     }
-    return sprite;
-}
\ No newline at end of file
+    return color;
+}
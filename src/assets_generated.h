@@ -0,0 +1,37 @@
+#pragma once
+// Generated by tools/aseprite_import.cpp from assets/textures/Texture_Atlas.aseprite, edit the slices and tags there instead
+
+enum SpriteID{
+    SPRITE_WHITE,
+    SPRITE_DICE,
+    SPRITE_DICE_ROLL,
+    SPRITE_FONT,
+
+    SPRITE_COUNT
+};
+
+enum AnimationID{
+    ANIMATION_DICE_ROLL,
+
+    ANIMATION_COUNT
+};
+
+constexpr Sprite SPRITES[(SPRITE_COUNT > 0 ? SPRITE_COUNT : 1)] = {
+    {{0, 0}, {1, 1}, 0},      // white
+    {{16, 0}, {16, 16}, 0},      // dice
+    {{16, 0}, {16, 16}, 0},      // dice_roll
+    {{0, 64}, {64, 36}, 0},      // font
+};
+
+constexpr AnimationFrame ANIMATION_FRAMES[] = {
+    {{16, 0}, {16, 16}, 0},      // dice_roll 0
+    {{32, 0}, {16, 16}, 0},      // dice_roll 1
+};
+
+constexpr unsigned short ANIMATION_TICKS[] = {
+    0, 1,
+};
+
+constexpr Animation ANIMATIONS[(ANIMATION_COUNT > 0 ? ANIMATION_COUNT : 1)] = {
+    {0, 2, 10.000000f, 0.200000f, true},      // dice_roll
+};
@@ -0,0 +1,19 @@
+#pragma once
+// Generated by tools/atlas_pack.cpp, add or change the images in assets/textures/sprites instead
+
+constexpr int ATLAS_PAGE_COUNT = 2;
+
+constexpr const char* ATLAS_PAGES[ATLAS_PAGE_COUNT] = {
+    "assets/textures/Texture_Atlas.png",
+    "assets/textures/Atlas_Page_1.png",
+};
+
+enum PackedSpriteID{
+    PACKED_SPRITE_REWIND,
+
+    PACKED_SPRITE_COUNT
+};
+
+constexpr Sprite PACKED_SPRITES[(PACKED_SPRITE_COUNT > 0 ? PACKED_SPRITE_COUNT : 1)] = {
+    {{0, 0}, {7, 5}, 1},      // REWIND
+};
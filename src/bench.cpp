@@ -0,0 +1,908 @@
+#include "engine_lib.h"
+#include "input.h"
+#include "game.h"
+#include "game.cpp"
+#include "render_interface.h"
+#include "particles.h"
+#include "animation.h"
+#include "spatial_hash.h"
+#include "world.h"
+#include "rewind.h"
+#include "simd_math.h"
+#include "collision.h"
+#include "sw_renderer.cpp"
+
+#include <chrono>
+#include <stdarg.h>
+
+//#####################################################################################################################################
+//                                                  Bench Constants
+//#####################################################################################################################################
+constexpr int BENCH_TILESIZE = 8;
+constexpr int BENCH_QUERY_COUNT = 4096;
+constexpr int MAX_BENCH_RESULTS = 128;
+constexpr double BENCH_REGRESSION_THRESHOLD = 15.0;    // percent, default for the baseline comparison
+constexpr int BENCH_SCENE_FRAMES = 600;
+
+//#####################################################################################################################################
+//                                                  Bench Structs
+//#####################################################################################################################################
+// Every recorded value is a cost, lower is better
+struct BenchResult{
+    char name[64];
+    double value;
+    const char* unit;
+    int bytes;                  // size of the data the bench works on, written when it is not 0
+};
+
+//#####################################################################################################################################
+//                                                  Bench Globals
+//#####################################################################################################################################
+static Array<BenchResult, MAX_BENCH_RESULTS> benchResults;
+
+//#####################################################################################################################################
+//                                                  Bench Utility
+//#####################################################################################################################################
+static unsigned int benchRandomState = 0x12345678;
+
+unsigned int bench_random(){
+    benchRandomState ^= benchRandomState << 13;
+    benchRandomState ^= benchRandomState >> 17;
+    benchRandomState ^= benchRandomState << 5;
+    return benchRandomState;
+}
+
+int bench_random_range(int min, int max){ return min + (int)(bench_random() % (unsigned int)(max - min)); }
+
+double bench_now_ms(){
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::milli>(now).count();
+}
+
+BenchResult* bench_record(const char* unit, double value, const char* nameFormat, ...){
+    SM_ASSERT_GUARD(!benchResults.is_full(), nullptr, "Too many bench results, raise MAX_BENCH_RESULTS");
+    BenchResult result = {};
+    va_list args;
+    va_start(args, nameFormat);
+    vsnprintf(result.name, sizeof(result.name), nameFormat, args);
+    va_end(args);
+    result.value = value;
+    result.unit = unit;
+    benchResults.add(result);
+    return &benchResults.elements[benchResults.count - 1];
+}
+
+// One result per line, so bench_compare_results can read it back without a JSON parser
+bool bench_write_results(const char* path){
+    auto file = fopen(path, "wb");
+    SM_ASSERT_GUARD(file, false, "Failed to open Bench results: %s", path);
+    fprintf(file, "{\n  \"results\": [\n");
+    for(int idx = 0; idx < benchResults.count; idx++){
+        BenchResult* result = &benchResults.elements[idx];
+        fprintf(file, "    {\"name\": \"%s\", \"value\": %.6f, \"unit\": \"%s\"", result->name, result->value, result->unit);
+        if(result->bytes) fprintf(file, ", \"bytes\": %d", result->bytes);
+        fprintf(file, "}%s\n", idx + 1 < benchResults.count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    SM_TRACE("Wrote %d bench results to %s", benchResults.count, path);
+    return true;
+}
+
+// Returns how many results are more than thresholdPercent slower than the same result in the baseline, plus how many
+// names are only on one side. A bench that was renamed or stopped recording fails the comparison instead of dropping out
+int bench_compare_results(char* baselinePath, double thresholdPercent, BumpAllocator* bumpAllocator){
+    int fileSize = 0;
+    char* data = read_file(baselinePath, &fileSize, bumpAllocator);
+    SM_ASSERT_GUARD(data, 0, "Failed to read Bench baseline: %s", baselinePath);
+
+    bool matched[MAX_BENCH_RESULTS] = {};
+    int regressions = 0, compared = 0, unmatched = 0;
+    for(char* line = data; line && *line; line = strchr(line, '\n') ? strchr(line, '\n') + 1 : nullptr){
+        char name[64];
+        double baseline = 0.0;
+        if(sscanf(line, " {\"name\": \"%63[^\"]\", \"value\": %lf", name, &baseline) != 2) continue;
+        int idx = 0;
+        while(idx < benchResults.count && strcmp(benchResults.elements[idx].name, name) != 0) idx++;
+        if(idx == benchResults.count){
+            SM_WARN("Baseline entry %s has no result", name);
+            unmatched++;
+            continue;
+        }
+        BenchResult* result = &benchResults.elements[idx];
+        matched[idx] = true;
+        compared++;
+        double change = baseline > 0.0 ? (result->value / baseline - 1.0) * 100.0 : 0.0;
+        if(change > thresholdPercent){
+            SM_WARN("Regression %-40s %12.4f %s -> %12.4f %s (%+.1f%%)", name, baseline, result->unit, result->value, result->unit, change);
+            regressions++;
+        }
+    }
+    for(int idx = 0; idx < benchResults.count; idx++){
+        if(matched[idx]) continue;
+        SM_WARN("Result %s has no baseline entry", benchResults.elements[idx].name);
+        unmatched++;
+    }
+    SM_TRACE("Compared %d of %d results against %s, %d slower than %.1f%%, %d names unmatched", compared, benchResults.count,
+             baselinePath, regressions, thresholdPercent, unmatched);
+    return regressions + unmatched;
+}
+
+//#####################################################################################################################################
+//                                                  Core Bench
+//#####################################################################################################################################
+// Per call cost of the small functions every frame leans on, each one looped often enough to hide the clock
+void bench_core(BumpAllocator* bumpAllocator, int callCount){
+    bumpAllocator->used = 0;
+    size_t sink = 0;
+
+    BumpAllocator scratch = {};
+    scratch.capacity = MB(64);
+    scratch.memory = bump_alloc(bumpAllocator, scratch.capacity);
+    double start = bench_now_ms();
+    for(int idx = 0; idx < callCount; idx++){
+        if(scratch.used + 64 > scratch.capacity) scratch.used = 0;
+        sink += (size_t)bump_alloc(&scratch, 24);
+    }
+    double bumpNs = (bench_now_ms() - start) * 1000000.0 / callCount;
+
+    auto array = (Array<IVec2, 1 << 16>*)bump_alloc(bumpAllocator, sizeof(Array<IVec2, 1 << 16>));
+    array->count = 0;
+    start = bench_now_ms();
+    for(int idx = 0; idx < callCount; idx++){
+        if(array->is_full()) array->clear();
+        array->add({idx, idx});
+    }
+    double arrayNs = (bench_now_ms() - start) * 1000000.0 / callCount;
+    sink += array->count;
+
+    int quadCount = MAX_TRANSFORMS / 2;
+    IVec2* positions = (IVec2*)bump_alloc(bumpAllocator, sizeof(IVec2) * quadCount);
+    for(int idx = 0; idx < quadCount; idx++) positions[idx] = {bench_random_range(0, 320), bench_random_range(0, 180)};
+    double quadMs = 0.0, spriteMs = 0.0;
+    int rounds = (callCount + quadCount - 1) / quadCount;
+    for(int round = 0; round < rounds; round++){
+        clear_render_passes();
+        start = bench_now_ms();
+        for(int idx = 0; idx < quadCount; idx++) draw_quad(vec_2(positions[idx]), {8.0f, 8.0f});
+        double mid = bench_now_ms();
+        clear_render_passes();
+        for(int idx = 0; idx < quadCount; idx++) draw_sprite(SPRITE_DICE, positions[idx]);
+        quadMs += mid - start;
+        spriteMs += bench_now_ms() - mid;
+    }
+    clear_render_passes();
+    double quadNs = quadMs * 1000000.0 / ((double)rounds * quadCount);
+    double spriteNs = spriteMs * 1000000.0 / ((double)rounds * quadCount);
+
+    start = bench_now_ms();
+    for(int idx = 0; idx < callCount; idx++){
+        IVec2 worldPos = screen_to_world(positions[idx % quadCount] * 4);
+        sink += worldPos.x + worldPos.y;
+    }
+    double screenToWorldNs = (bench_now_ms() - start) * 1000000.0 / callCount;
+
+    float projectionSum = 0.0f;
+    start = bench_now_ms();
+    for(int idx = 0; idx < callCount; idx++){
+        Vec2 pos = vec_2(positions[idx % quadCount]);
+        Mat4 projection = orthographic_projection(pos.x, pos.x + 320.0f, pos.y, pos.y + 180.0f);
+        projectionSum += projection.values[3].x;
+    }
+    double projectionNs = (bench_now_ms() - start) * 1000000.0 / callCount;
+
+    // Dice against dice at random offsets around each other, about half of them touch
+    CollisionMask dice = get_collision_mask(SPRITE_DICE);
+    int overlaps = 0;
+    start = bench_now_ms();
+    for(int idx = 0; idx < callCount; idx++){
+        IVec2 offset = positions[idx % quadCount];
+        overlaps += masks_overlap(dice, {0, 0}, dice, {offset.x % 32 - 16, offset.y % 32 - 16});
+    }
+    double masksOverlapNs = (bench_now_ms() - start) * 1000000.0 / callCount;
+
+    SM_TRACE("core   bump_alloc %6.2f ns, Array::add %6.2f ns, draw_quad %6.2f ns, draw_sprite %6.2f ns (sink %zu)",
+             bumpNs, arrayNs, quadNs, spriteNs, sink);
+    SM_TRACE("core   screen_to_world %6.2f ns, orthographic_projection %6.2f ns (sink %.1f)", screenToWorldNs, projectionNs, projectionSum);
+    SM_TRACE("core   masks_overlap %6.2f ns (%d overlaps)", masksOverlapNs, overlaps);
+    bench_record("ns", bumpNs, "core/bump_alloc");
+    bench_record("ns", arrayNs, "core/array_add");
+    bench_record("ns", quadNs, "core/draw_quad");
+    bench_record("ns", spriteNs, "core/draw_sprite");
+    bench_record("ns", screenToWorldNs, "core/screen_to_world");
+    bench_record("ns", projectionNs, "core/orthographic_projection");
+    bench_record("ns", masksOverlapNs, "core/masks_overlap");
+}
+
+//#####################################################################################################################################
+//                                                  Spatial Hash Bench
+//#####################################################################################################################################
+void bench_spatial_hash(BumpAllocator* bumpAllocator, int entityCount){
+    bumpAllocator->used = 0;
+
+    // Constant density: one entity per 64x64 pixel area on average, so only the total count changes between runs
+    int worldSide = 1;
+    while(worldSide * worldSide < entityCount) worldSide++;
+    worldSide *= 64;
+
+    SpatialEntity* entities = (SpatialEntity*)bump_alloc(bumpAllocator, sizeof(SpatialEntity) * entityCount);
+    for(int idx = 0; idx < entityCount; idx++){
+        entities[idx].pos = {bench_random_range(0, worldSide), bench_random_range(0, worldSide)};
+        entities[idx].size = {bench_random_range(BENCH_TILESIZE, 2 * BENCH_TILESIZE), bench_random_range(BENCH_TILESIZE, 2 * BENCH_TILESIZE)};
+    }
+    SpatialHash hash = make_spatial_hash(bumpAllocator, entityCount, 4 * BENCH_TILESIZE);
+    int* results = (int*)bump_alloc(bumpAllocator, sizeof(int) * entityCount);
+
+    int buildIterations = entityCount >= 1000000 ? 5 : 20;
+    double start = bench_now_ms();
+    for(int iteration = 0; iteration < buildIterations; iteration++){
+        spatial_hash_build(&hash, entities, entityCount);
+    }
+    double buildMs = (bench_now_ms() - start) / buildIterations;
+
+    long long hits = 0;
+    start = bench_now_ms();
+    for(int query = 0; query < BENCH_QUERY_COUNT; query++){
+        IVec2 pos = {bench_random_range(0, worldSide), bench_random_range(0, worldSide)};
+        hits += spatial_hash_query_aabb(&hash, pos, {64, 64}, results, entityCount);
+        hits += spatial_hash_query_point(&hash, pos, results, entityCount);
+        hits += spatial_hash_query_radius(&hash, pos, 48, results, entityCount);
+    }
+    double queryUs = (bench_now_ms() - start) * 1000.0 / (BENCH_QUERY_COUNT * 3);
+
+    SM_TRACE("spatial_hash %8d entities: build %8.3f ms (%6.2f ns/entity), query %7.3f us avg, %lld hits",
+             entityCount, buildMs, buildMs * 1000000.0 / entityCount, queryUs, hits);
+    bench_record("ms", buildMs, "spatial_hash/%d/build", entityCount);
+    bench_record("us", queryUs, "spatial_hash/%d/query", entityCount);
+}
+
+//#####################################################################################################################################
+//                                                  Particle Bench
+//#####################################################################################################################################
+void bench_particles(int particleCount){
+    new(particleSystem) ParticleSystem();
+
+    ParticleEmitterDesc snow = {};
+    snow.spriteID = SPRITE_WHITE;
+    snow.pos = {160.0f, 0.0f};
+    snow.spawnExtent = {160.0f, 0.0f};
+    snow.velMin = {-10.0f, 10.0f};
+    snow.velMax = {10.0f, 30.0f};
+    snow.gravity = 5.0f;
+    snow.lifetime = 1000.0f;
+    int emitter = create_particle_emitter(snow);
+    emit_particles(emitter, particleCount);
+
+    int frames = 240;
+    double updateMs = 0.0, drawMs = 0.0;
+    for(int frame = 0; frame < frames; frame++){
+        clear_render_passes();
+        double start = bench_now_ms();
+        update_particles(1.0f / 60.0f);
+        double mid = bench_now_ms();
+        draw_particles();
+        updateMs += mid - start;
+        drawMs += bench_now_ms() - mid;
+    }
+    SM_TRACE("particles    %8d live: update %7.3f ms/frame, draw %7.3f ms/frame",
+             particleSystem->count, updateMs / frames, drawMs / frames);
+    bench_record("ms", updateMs / frames, "particles/%d/update", particleCount);
+    bench_record("ms", drawMs / frames, "particles/%d/draw", particleCount);
+}
+
+//#####################################################################################################################################
+//                                                  Sprite Emission Bench
+//#####################################################################################################################################
+void bench_sprite_emission(BumpAllocator* bumpAllocator, int spriteCount){
+    bumpAllocator->used = 0;
+    IVec2* positions = (IVec2*)bump_alloc(bumpAllocator, sizeof(IVec2) * spriteCount);
+    for(int idx = 0; idx < spriteCount; idx++){
+        positions[idx] = {bench_random_range(0, 320), bench_random_range(0, 180)};
+    }
+
+    int frames = 100;
+    double singleMs = 0.0, batchMs = 0.0;
+    for(int frame = 0; frame < frames; frame++){
+        clear_render_passes();
+        double start = bench_now_ms();
+        for(int idx = 0; idx < spriteCount; idx++){
+            draw_sprite(SPRITE_DICE, positions[idx]);
+        }
+        double mid = bench_now_ms();
+        clear_render_passes();
+        draw_sprites(SPRITE_DICE, positions, spriteCount);
+        singleMs += mid - start;
+        batchMs += bench_now_ms() - mid;
+    }
+    SM_TRACE("sprites      %8d: draw_sprite %7.3f ms/frame, draw_sprites %7.3f ms/frame",
+             spriteCount, singleMs / frames, batchMs / frames);
+    bench_record("ms", singleMs / frames, "sprites/%d/draw_sprite", spriteCount);
+    bench_record("ms", batchMs / frames, "sprites/%d/draw_sprites", spriteCount);
+}
+
+//#####################################################################################################################################
+//                                                  Math Bench
+//#####################################################################################################################################
+// Scalar references, what the call sites computed by hand before simd_math.h
+Vec4 bench_mul_scalar(Mat4 m, Vec4 v){
+    Vec4 result = {};
+    for(int column = 0; column < 4; column++){
+        for(int row = 0; row < 4; row++) result.values[row] += m.values[column].values[row] * v.values[column];
+    }
+    return result;
+}
+
+Mat4 bench_mul_scalar(Mat4 a, Mat4 b){
+    Mat4 result = {};
+    for(int column = 0; column < 4; column++) result.values[column] = bench_mul_scalar(a, b.values[column]);
+    return result;
+}
+
+void bench_math(BumpAllocator* bumpAllocator, int pointCount){
+    bumpAllocator->used = 0;
+    Vec4* points = (Vec4*)bump_alloc(bumpAllocator, sizeof(Vec4) * pointCount);
+    Vec4* results = (Vec4*)bump_alloc(bumpAllocator, sizeof(Vec4) * pointCount);
+    for(int idx = 0; idx < pointCount; idx++){
+        points[idx] = {{(float)bench_random_range(-320, 640), (float)bench_random_range(-180, 360), 0.0f, 1.0f}};
+    }
+    Mat4 projection = orthographic_projection(0.0f, 320.0f, 0.0f, 180.0f);
+
+    int frames = 100;
+    double scalarMs = 0.0, simdMs = 0.0;
+    float checksum = 0.0f;
+    for(int frame = 0; frame < frames; frame++){
+        double start = bench_now_ms();
+        for(int idx = 0; idx < pointCount; idx++) results[idx] = bench_mul_scalar(projection, points[idx]);
+        double scalarEnd = bench_now_ms();
+        checksum += results[frame].x;
+        for(int idx = 0; idx < pointCount; idx++) results[idx] = projection * points[idx];
+        double simdEnd = bench_now_ms();
+        checksum += results[frame].x;
+
+        scalarMs += scalarEnd - start;
+        simdMs += simdEnd - scalarEnd;
+    }
+
+    int chainLength = 1 << 20;
+    Mat4 scalarChain = identity_mat4(), simdChain = identity_mat4();
+    Mat4 step = orthographic_projection(-1.0f, 1.0f, -1.0f, 1.0f);
+    double start = bench_now_ms();
+    for(int idx = 0; idx < chainLength; idx++) scalarChain = bench_mul_scalar(step, scalarChain);
+    double mid = bench_now_ms();
+    for(int idx = 0; idx < chainLength; idx++) simdChain = step * simdChain;
+    double end = bench_now_ms();
+    checksum += scalarChain.ax + simdChain.ax;
+
+    SM_TRACE("math   %8d points: Mat4*Vec4 scalar %7.3f ms, simd %7.3f ms (checksum %.1f)",
+             pointCount, scalarMs / frames, simdMs / frames, checksum);
+    SM_TRACE("math   %8d Mat4*Mat4: scalar %7.3f ns, simd %7.3f ns", chainLength, (mid - start) * 1e6 / chainLength,
+             (end - mid) * 1e6 / chainLength);
+    bench_record("ms", simdMs / frames, "math/%d/mat4_vec4", pointCount);
+    bench_record("ns", (end - mid) * 1e6 / chainLength, "math/mat4_mat4");
+}
+
+//#####################################################################################################################################
+//                                                  Animation Bench
+//#####################################################################################################################################
+void bench_animations(BumpAllocator* bumpAllocator, int instanceCount){
+    bumpAllocator->used = 0;
+    AnimationState* states = (AnimationState*)bump_alloc(bumpAllocator, sizeof(AnimationState) * instanceCount);
+    IVec2* positions = (IVec2*)bump_alloc(bumpAllocator, sizeof(IVec2) * instanceCount);
+    for(int idx = 0; idx < instanceCount; idx++){
+        states[idx] = make_animation_state((AnimationID)bench_random_range(0, ANIMATION_COUNT));
+        states[idx].time = bench_random_range(0, 1000) / 1000.0f * ANIMATIONS[states[idx].animationID].duration;
+        positions[idx] = {bench_random_range(0, 320), bench_random_range(0, 180)};
+    }
+
+    int frames = 100;
+    double updateMs = 0.0, drawMs = 0.0;
+    for(int frame = 0; frame < frames; frame++){
+        clear_render_passes();
+        double start = bench_now_ms();
+        update_animations(states, instanceCount, 1.0f / 60.0f);
+        double mid = bench_now_ms();
+        draw_animations(states, positions, instanceCount);
+        updateMs += mid - start;
+        drawMs += bench_now_ms() - mid;
+    }
+    SM_TRACE("animations   %8d: update %7.3f ms/frame, draw %7.3f ms/frame", instanceCount, updateMs / frames, drawMs / frames);
+    bench_record("ms", updateMs / frames, "animations/%d/update", instanceCount);
+    bench_record("ms", drawMs / frames, "animations/%d/draw", instanceCount);
+}
+
+//#####################################################################################################################################
+//                                                  Text Bench
+//#####################################################################################################################################
+// lineCount lines of debug text every frame, once straight from the layout cache and once laid out from scratch
+void bench_text(BumpAllocator* bumpAllocator, int lineCount, int lineLength){
+    bumpAllocator->used = 0;
+    char** lines = (char**)bump_alloc(bumpAllocator, sizeof(char*) * lineCount);
+    for(int line = 0; line < lineCount; line++){
+        lines[line] = bump_alloc(bumpAllocator, lineLength + 1);
+        for(int idx = 0; idx < lineLength; idx++) lines[line][idx] = (char)bench_random_range(FONT_FIRST_CHAR, FONT_LAST_CHAR + 1);
+        lines[line][lineLength] = 0;
+    }
+
+    int frames = 100;
+    double cachedMs = 0.0, uncachedMs = 0.0;
+    for(int frame = 0; frame < frames; frame++){
+        clear_render_passes();
+        double start = bench_now_ms();
+        for(int line = 0; line < lineCount; line++){
+            draw_text(lines[line], {0.0f, (float)(line % 30) * FONT_CELL_SIZE.y});
+        }
+        double mid = bench_now_ms();
+        clear_render_passes();
+        clear_text_layouts(&renderData->textCache);
+        for(int line = 0; line < lineCount; line++){
+            draw_text(lines[line], {0.0f, (float)(line % 30) * FONT_CELL_SIZE.y});
+        }
+        if(frame > 0) cachedMs += mid - start;
+        uncachedMs += bench_now_ms() - mid;
+    }
+    SM_TRACE("text         %8d chars: cached %7.3f ms/frame, uncached %7.3f ms/frame",
+             lineCount * lineLength, cachedMs / (frames - 1), uncachedMs / frames);
+    bench_record("ms", cachedMs / (frames - 1), "text/%d/cached", lineCount * lineLength);
+    bench_record("ms", uncachedMs / frames, "text/%d/uncached", lineCount * lineLength);
+}
+
+//#####################################################################################################################################
+//                                                  Level Bench
+//#####################################################################################################################################
+// Random caves: cellular automaton smoothing of 45% noise, one byte per tile
+unsigned char* bench_generate_caves(BumpAllocator* bumpAllocator, IVec2 sizeInTiles){
+    int tileCount = sizeInTiles.x * sizeInTiles.y;
+    unsigned char* solid = (unsigned char*)bump_alloc(bumpAllocator, tileCount);
+    unsigned char* smoothed = (unsigned char*)bump_alloc(bumpAllocator, tileCount);
+    for(int idx = 0; idx < tileCount; idx++) solid[idx] = bench_random() % 100 < 45;
+    for(int pass = 0; pass < 4; pass++){
+        for(int y = 0; y < sizeInTiles.y; y++){
+            for(int x = 0; x < sizeInTiles.x; x++){
+                int walls = 0;
+                for(int dy = -1; dy <= 1; dy++){
+                    for(int dx = -1; dx <= 1; dx++){
+                        int nx = x + dx, ny = y + dy;
+                        walls += (nx < 0 || ny < 0 || nx >= sizeInTiles.x || ny >= sizeInTiles.y) ? 1 : solid[ny * sizeInTiles.x + nx];
+                    }
+                }
+                smoothed[y * sizeInTiles.x + x] = walls >= 5;
+            }
+        }
+        unsigned char* swap = solid;
+        solid = smoothed;
+        smoothed = swap;
+    }
+    return solid;
+}
+
+bool bench_write_level(char* path, unsigned char* solid, IVec2 sizeInTiles){
+    IVec2 sizeInChunks = {(sizeInTiles.x + CHUNK_MASK) >> CHUNK_SHIFT, (sizeInTiles.y + CHUNK_MASK) >> CHUNK_SHIFT};
+    unsigned char layerBits[LEVEL_LAYER_COUNT * LEVEL_CHUNK_BITMAP_SIZE];
+    LevelWriter writer;
+    if(!begin_level_file(&writer, path, sizeInTiles)) return false;
+    for(int cy = 0; cy < sizeInChunks.y; cy++){
+        for(int cx = 0; cx < sizeInChunks.x; cx++){
+            memset(layerBits, 0, sizeof(layerBits));
+            bool empty = true;
+            for(int y = 0; y < CHUNK_SIZE; y++){
+                for(int x = 0; x < CHUNK_SIZE; x++){
+                    int tx = cx * CHUNK_SIZE + x, ty = cy * CHUNK_SIZE + y;
+                    if(tx >= sizeInTiles.x || ty >= sizeInTiles.y || !solid[ty * sizeInTiles.x + tx]) continue;
+                    int bit = y * CHUNK_SIZE + x;
+                    layerBits[bit >> 3] |= 1 << (bit & 7);
+                    empty = false;
+                }
+            }
+            if(!empty) add_level_chunk(&writer, {cx, cy}, layerBits);
+        }
+    }
+    return end_level_file(&writer);
+}
+
+// Random caves written through LevelWriter and read back chunk by chunk the same way the loader thread does,
+// including neighbour mask derivation
+void bench_level(BumpAllocator* bumpAllocator, IVec2 sizeInTiles){
+    bumpAllocator->used = 0;
+    int tileCount = sizeInTiles.x * sizeInTiles.y;
+    IVec2 sizeInChunks = {(sizeInTiles.x + CHUNK_MASK) >> CHUNK_SHIFT, (sizeInTiles.y + CHUNK_MASK) >> CHUNK_SHIFT};
+    unsigned char* solid = bench_generate_caves(bumpAllocator, sizeInTiles);
+
+    char path[] = "bench_level.lvl";
+    double start = bench_now_ms();
+    if(!bench_write_level(path, solid, sizeInTiles)) return;
+    double writeMs = bench_now_ms() - start;
+
+    int fileSize = 0;
+    start = bench_now_ms();
+    char* data = read_file(path, &fileSize, bumpAllocator);
+    LevelView level;
+    if(!open_level_view(&level, data, fileSize)) return;
+    double openMs = bench_now_ms() - start;
+
+    // The loader decodes into chunks of a ChunkWorld, a single one is enough to drive decode_level_chunk
+    ChunkWorld* world = (ChunkWorld*)bump_alloc(bumpAllocator, sizeof(ChunkWorld));
+    world->sizeInTiles = sizeInTiles;
+    world->sizeInChunks = sizeInChunks;
+    world->level = level;
+    long long visibleTiles = 0;
+    start = bench_now_ms();
+    for(int cy = 0; cy < sizeInChunks.y; cy++){
+        for(int cx = 0; cx < sizeInChunks.x; cx++){
+            decode_level_chunk(world, {cx, cy}, world->chunks[0].tiles);
+            for(int idx = 0; idx < CHUNK_TILE_COUNT; idx++) visibleTiles += world->chunks[0].tiles[idx].isVisible;
+        }
+    }
+    double readMs = bench_now_ms() - start;
+    remove(path);
+
+    double rawMB = tileCount * sizeof(Tile) / (1024.0 * 1024.0);
+    SM_TRACE("level   %5dx%-5d %8.2f MB raw tiles, %6.2f MB file (%d chunks)", sizeInTiles.x, sizeInTiles.y, rawMB,
+             fileSize / (1024.0 * 1024.0), level.header->chunkCount);
+    SM_TRACE("level   write %8.1f ms (%7.1f MB/s, %6.1f Mtiles/s), open %6.3f ms, decode %8.1f ms (%7.1f MB/s, %6.1f Mtiles/s), %lld solid",
+             writeMs, rawMB / (writeMs / 1000.0), tileCount / (writeMs * 1000.0), openMs,
+             readMs, rawMB / (readMs / 1000.0), tileCount / (readMs * 1000.0), visibleTiles);
+    bench_record("ms", writeMs, "level/%dx%d/write", sizeInTiles.x, sizeInTiles.y);
+    bench_record("ms", openMs, "level/%dx%d/open", sizeInTiles.x, sizeInTiles.y);
+    bench_record("ms", readMs, "level/%dx%d/decode", sizeInTiles.x, sizeInTiles.y);
+}
+
+//#####################################################################################################################################
+//                                                  Rewind Bench
+//#####################################################################################################################################
+// Captures a state where changedBytes random bytes change every frame, like a 60 Hz game loop would. The name stays
+// the same when the state changes size, the size goes into the results next to it
+void bench_rewind(BumpAllocator* bumpAllocator, const char* name, int snapshotSize, int changedBytes, int frameCapacity, int dataSize){
+    bumpAllocator->used = 0;
+    char* state = bump_alloc(bumpAllocator, snapshotSize);
+    for(int idx = 0; idx < snapshotSize; idx++) state[idx] = idx < snapshotSize / 2 ? 0 : (char)bench_random();
+    RewindBuffer buffer = make_rewind_buffer(bumpAllocator, snapshotSize, frameCapacity, 60, dataSize);
+
+    int frames = frameCapacity * 4;
+    double captureMs = 0.0, maxCaptureMs = 0.0;
+    for(int frame = 0; frame < frames; frame++){
+        for(int n = 0; n < changedBytes; n++) state[bench_random_range(0, snapshotSize)] = (char)bench_random();
+        double start = bench_now_ms();
+        rewind_capture(&buffer, state);
+        double ms = bench_now_ms() - start;
+        captureMs += ms;
+        if(ms > maxCaptureMs) maxCaptureMs = ms;
+    }
+
+    int restores = 1000;
+    double restoreMs = 0.0, maxRestoreMs = 0.0;
+    for(int n = 0; n < restores; n++){
+        double start = bench_now_ms();
+        rewind_restore(&buffer, bench_random_range(0, buffer.frameCount), state);
+        double ms = bench_now_ms() - start;
+        restoreMs += ms;
+        if(ms > maxRestoreMs) maxRestoreMs = ms;
+    }
+
+    SM_TRACE("rewind  %7d byte state, %5d bytes/frame changed: %4d frames (%5.1f s) kept in %7.1f KB", snapshotSize, changedBytes,
+             buffer.frameCount, buffer.frameCount / 60.0, get_rewind_memory_size(&buffer) / 1024.0);
+    SM_TRACE("rewind  capture %7.3f us avg (%7.3f max, %5.3f%% of a 60 Hz frame), restore %7.3f us avg (%7.3f max)",
+             captureMs * 1000.0 / frames, maxCaptureMs * 1000.0, captureMs / frames / (1000.0 / 60.0) * 100.0,
+             restoreMs * 1000.0 / restores, maxRestoreMs * 1000.0);
+    BenchResult* capture = bench_record("us", captureMs * 1000.0 / frames, "rewind/%s/capture", name);
+    BenchResult* restore = bench_record("us", restoreMs * 1000.0 / restores, "rewind/%s/restore", name);
+    if(capture) capture->bytes = snapshotSize;
+    if(restore) restore->bytes = snapshotSize;
+}
+
+//#####################################################################################################################################
+//                                                  Scene Bench
+//#####################################################################################################################################
+// Whole frames the way headless.exe runs them, update_game plus the software renderer on a random cave level. Chunks
+// requested in a frame are waited for outside the timed part so every run streams the same chunks at the same frame.
+void bench_scenes(BumpAllocator* bumpAllocator, BumpAllocator* transientStorage, IVec2 sizeInTiles, int frameCount){
+    bumpAllocator->used = 0;
+    char levelPath[] = "bench_scene.lvl";
+    unsigned char* solid = bench_generate_caves(bumpAllocator, sizeInTiles);
+    if(!bench_write_level(levelPath, solid, sizeInTiles)) return;
+    bumpAllocator->used = 0;
+
+    // update_game only picks up new pointers when renderData changes, the game globals are set here directly
+    gameState = (GameState*)bump_alloc(bumpAllocator, sizeof(GameState));
+    *gameState = {};
+    chunkWorld = (ChunkWorld*)bump_alloc(bumpAllocator, sizeof(ChunkWorld));
+    new(chunkWorld) ChunkWorld();           // holds atomics and is too big for a temporary, value initialized in place
+    rewindBuffer = (RewindBuffer*)bump_alloc(bumpAllocator, sizeof(RewindBuffer));
+    *rewindBuffer = make_rewind_buffer(bumpAllocator, sizeof(GameState), REWIND_FRAMES, REWIND_KEYFRAME_INTERVAL, REWIND_DATA_SIZE);
+    new(particleSystem) ParticleSystem();
+    memset(input->keys, 0, sizeof(input->keys));
+    ChunkWorld* world = chunkWorld;
+
+    init_chunk_world(world, sizeInTiles, "levels/bench");
+    int levelSize = 0;
+    char* levelData = read_file(levelPath, &levelSize, bumpAllocator);
+    LevelView level = {};
+    if(levelData) open_level_view(&level, levelData, levelSize);
+    attach_level(world, level);
+    world->loaderRunning = true;
+    std::thread chunkLoader(run_chunk_loader, world);
+
+    // The first frame initializes the game and places the camera, the chunks under it are resident afterwards
+    update_game(gameState, renderData, input, particleSystem, chunkWorld, rewindBuffer);
+    clear_render_passes();
+    wait_for_chunk_loader(world);
+
+    // Caves: the camera pans diagonally, every frame streams and draws a moving window of chunks
+    double updateMs = 0.0, renderMs = 0.0;
+    for(int frame = 0; frame < frameCount; frame++){
+        renderData->gameCamera.position.x += 3.0f;
+        renderData->gameCamera.position.y -= 1.0f;
+        double start = bench_now_ms();
+        update_game(gameState, renderData, input, particleSystem, chunkWorld, rewindBuffer);
+        double mid = bench_now_ms();
+        sw_render(transientStorage);
+        updateMs += mid - start;
+        renderMs += bench_now_ms() - mid;
+        transientStorage->used = 0;
+        wait_for_chunk_loader(world);
+    }
+    SM_TRACE("scene   caves    %5d frames: update %7.3f ms/frame, render %7.3f ms/frame", frameCount, updateMs / frameCount,
+             renderMs / frameCount);
+    bench_record("ms", updateMs / frameCount, "scene/caves/update");
+    bench_record("ms", renderMs / frameCount, "scene/caves/render");
+
+    // The masks of the tiles under the camera, which are all resident now
+    TileRange visibleTiles = get_visible_tile_range(renderData->gameCamera, TILESIZE, world->sizeInTiles);
+    IVec2 visibleSize = visibleTiles.max - visibleTiles.min;
+    int maskCalls = 0, maskSum = 0;
+    double maskStart = bench_now_ms();
+    for(int round = 0; round < 100; round++){
+        for(int y = visibleTiles.min.y; y < visibleTiles.max.y; y++){
+            for(int x = visibleTiles.min.x; x < visibleTiles.max.x; x++) maskSum += get_neigbour_mask(x, y);
+        }
+        maskCalls += visibleSize.x * visibleSize.y;
+    }
+    double maskNs = (bench_now_ms() - maskStart) * 1000000.0 / maskCalls;
+    int updateCalls = 10000;
+    maskStart = bench_now_ms();
+    for(int idx = 0; idx < updateCalls; idx++){
+        update_neigbour_masks({bench_random_range(visibleTiles.min.x, visibleTiles.max.x), bench_random_range(visibleTiles.min.y, visibleTiles.max.y)});
+    }
+    double updateMaskNs = (bench_now_ms() - maskStart) * 1000000.0 / updateCalls;
+    SM_TRACE("scene   get_neigbour_mask %7.2f ns, update_neigbour_masks %7.2f ns (sum %d)", maskNs, updateMaskNs, maskSum);
+    bench_record("ns", maskNs, "scene/get_neigbour_mask");
+    bench_record("ns", updateMaskNs, "scene/update_neigbour_masks");
+
+    // Dice dropped anywhere on screen against the caves, a mix of open space, walls and edges
+    CollisionMask dice = get_collision_mask(SPRITE_DICE);
+    int tileCalls = 100000, tileHits = 0;
+    int spanX = visibleSize.x * TILESIZE - dice.size.x, spanY = visibleSize.y * TILESIZE - dice.size.y;
+    maskStart = bench_now_ms();
+    for(int idx = 0; idx < tileCalls; idx++){
+        IVec2 pos = {visibleTiles.min.x * TILESIZE + bench_random_range(0, spanX), visibleTiles.min.y * TILESIZE + bench_random_range(0, spanY)};
+        tileHits += mask_overlaps_tiles(world, dice, pos, TILESIZE);
+    }
+    double tileOverlapNs = (bench_now_ms() - maskStart) * 1000000.0 / tileCalls;
+    SM_TRACE("scene   mask_overlaps_tiles %7.2f ns (%d of %d hit)", tileOverlapNs, tileHits, tileCalls);
+    bench_record("ns", tileOverlapNs, "scene/mask_overlaps_tiles");
+
+    // Painting: a cursor sweeps the screen and fills or clears one tile every frame, with neighbour masks and dust
+    updateMs = 0.0;
+    renderMs = 0.0;
+    ViewRect view = get_camera_view(renderData->gameCamera);
+    for(int frame = 0; frame < frameCount; frame++){
+        int column = frame % ((int)(view.max.x - view.min.x) / TILESIZE);
+        int row = frame / ((int)(view.max.x - view.min.x) / TILESIZE);
+        bool fill = row % 2 == 0;
+        input->keys[KEY_MOUSE_LEFT].isDown = fill;
+        input->keys[KEY_MOUSE_RIGHT].isDown = !fill;
+        input->mousePosWorld = {(int)view.min.x + column * TILESIZE + TILESIZE / 2,
+                                (int)view.min.y + (row * 3 % (int)((view.max.y - view.min.y) / TILESIZE)) * TILESIZE + TILESIZE / 2};
+        double start = bench_now_ms();
+        update_game(gameState, renderData, input, particleSystem, chunkWorld, rewindBuffer);
+        double mid = bench_now_ms();
+        sw_render(transientStorage);
+        updateMs += mid - start;
+        renderMs += bench_now_ms() - mid;
+        transientStorage->used = 0;
+        wait_for_chunk_loader(world);
+    }
+    input->keys[KEY_MOUSE_LEFT].isDown = false;
+    input->keys[KEY_MOUSE_RIGHT].isDown = false;
+    SM_TRACE("scene   painting %5d frames: update %7.3f ms/frame, render %7.3f ms/frame, %d particles", frameCount,
+             updateMs / frameCount, renderMs / frameCount, particleSystem->count);
+    bench_record("ms", updateMs / frameCount, "scene/painting/update");
+    bench_record("ms", renderMs / frameCount, "scene/painting/render");
+
+    world->loaderRunning = false;
+    chunkLoader.join();
+    remove(levelPath);
+}
+
+// spriteCount sprites scattered over the screen, emitted and rendered every frame
+void bench_sprite_scene(BumpAllocator* bumpAllocator, BumpAllocator* transientStorage, int spriteCount, int frameCount){
+    bumpAllocator->used = 0;
+    IVec2* positions = (IVec2*)bump_alloc(bumpAllocator, sizeof(IVec2) * spriteCount);
+    ViewRect view = get_camera_view(renderData->gameCamera);
+    for(int idx = 0; idx < spriteCount; idx++){
+        positions[idx] = {bench_random_range((int)view.min.x, (int)view.max.x), bench_random_range((int)view.min.y, (int)view.max.y)};
+    }
+
+    double drawMs = 0.0, renderMs = 0.0;
+    for(int frame = 0; frame < frameCount; frame++){
+        clear_render_passes();
+        double start = bench_now_ms();
+        draw_sprites(SPRITE_DICE, positions, spriteCount);
+        double mid = bench_now_ms();
+        sw_render(transientStorage);
+        drawMs += mid - start;
+        renderMs += bench_now_ms() - mid;
+        transientStorage->used = 0;
+    }
+    SM_TRACE("scene   sprites  %5d frames x %d: draw %7.3f ms/frame, render %7.3f ms/frame", frameCount, spriteCount,
+             drawMs / frameCount, renderMs / frameCount);
+    bench_record("ms", drawMs / frameCount, "scene/sprites/%d/draw", spriteCount);
+    bench_record("ms", renderMs / frameCount, "scene/sprites/%d/render", spriteCount);
+}
+
+//#####################################################################################################################################
+//                                                  Batch Simulation Bench
+//#####################################################################################################################################
+// Recorded play the way a player produces it: movement keys held for a while and let go, now and then R held to rewind
+void bench_record_input_stream(Input* stream, int frameCount){
+    KeyCodeID keys[] = {KEY_W, KEY_A, KEY_S, KEY_D, KEY_R};
+    int holdFrames[5] = {};
+    Input previous = {};
+    for(int frame = 0; frame < frameCount; frame++){
+        Input* in = &stream[frame];
+        *in = {};
+        for(int key = 0; key < 5; key++){
+            bool isRewind = keys[key] == KEY_R;
+            if(holdFrames[key] > 0) holdFrames[key]--;
+            else if(bench_random() % (isRewind ? 400u : 40u) == 0){
+                holdFrames[key] = isRewind ? bench_random_range(30, 120) : bench_random_range(5, 90);
+            }
+            Key* state = &in->keys[keys[key]];
+            state->isDown = holdFrames[key] > 0;
+            bool changed = state->isDown != previous.keys[keys[key]].isDown;
+            state->justPressed = changed && state->isDown;
+            state->justReleased = changed && !state->isDown;
+            state->halfTransitionCount = changed;
+        }
+        previous = *in;
+    }
+}
+
+void bench_batch_simulation(BumpAllocator* bumpAllocator, int instanceCount, int streamCount, int frameCount){
+    bumpAllocator->used = 0;
+    GameState* states = (GameState*)bump_alloc(bumpAllocator, sizeof(GameState) * instanceCount);
+    Input* inputs = (Input*)bump_alloc(bumpAllocator, sizeof(Input) * streamCount * frameCount);
+    for(int idx = 0; idx < instanceCount; idx++) states[idx] = {};
+    for(int stream = 0; stream < streamCount; stream++) bench_record_input_stream(&inputs[stream * frameCount], frameCount);
+
+    SimulationReport report = {};
+    simulate_game_batch(states, instanceCount, inputs, streamCount, frameCount, bumpAllocator, &report);
+    SM_TRACE("batch   %6d instances x %4d frames: %8.2f ms on %2d threads, %12.0f frames/s, %12.0f frames/s per core",
+             instanceCount, frameCount, report.elapsedMs, report.threadCount, report.framesPerSecond, report.framesPerSecondPerCore);
+    bench_record("ms", report.elapsedMs, "batch/%dx%d", instanceCount, frameCount);
+}
+
+//#####################################################################################################################################
+//                                                  Startup Bench
+//#####################################################################################################################################
+// The files gl_load_startup_assets reads, without the GL context it is compiled against
+bool bench_load_startup_assets(BumpAllocator* storage){
+    int fileSize = 0;
+    bool loaded = read_file("assets/shaders/quad.vert", &fileSize, storage) && read_file("assets/shaders/quad.frag", &fileSize, storage) &&
+                  read_file("assets/shaders/tilemap.vert", &fileSize, storage) && read_file("assets/shaders/tilemap.frag", &fileSize, storage);
+    return load_indexed_atlas(storage) && loaded;
+}
+
+// make_bump_allocator before it left zeroing to calloc, every page is written up front. Called through a pointer,
+// the compiler would turn malloc and memset back into calloc
+static void* (*volatile bench_memset)(void*, int, size_t) = memset;
+BumpAllocator bench_make_zeroed_allocator(size_t size){
+    BumpAllocator ba = {};
+    ba.memory = (char*)malloc(size);
+    SM_ASSERT(ba.memory, "Failed to allocate Memory!");
+    ba.capacity = size;
+    bench_memset(ba.memory, 0, size);
+    return ba;
+}
+
+// The persistent state main sets up before its first frame
+void bench_init_startup_state(BumpAllocator* persistentStorage){
+    bump_alloc(persistentStorage, sizeof(GameState));
+    bump_alloc(persistentStorage, sizeof(Input));
+    bump_alloc(persistentStorage, sizeof(RenderData));
+    bump_alloc(persistentStorage, sizeof(ParticleSystem));
+    ChunkWorld* world = (ChunkWorld*)bump_alloc(persistentStorage, sizeof(ChunkWorld));
+    RewindBuffer* rewind = (RewindBuffer*)bump_alloc(persistentStorage, sizeof(RewindBuffer));
+    *rewind = make_rewind_buffer(persistentStorage, sizeof(GameState), REWIND_FRAMES, REWIND_KEYFRAME_INTERVAL, REWIND_DATA_SIZE);
+    init_chunk_world(world, LEVEL_SIZE, "levels/bench");
+}
+
+// Startup up to gl_init without the window, the GL calls and game.dll, which need the platform layer. serial is the
+// order main used to run it in, with arenas zeroed up front. overlapped is main now: calloc'd arenas and the asset
+// files read on a worker while the main thread sets up its state. Arena pages calloc leaves untouched are faulted in
+// whenever they are first used, mostly after the first frame
+void bench_startup(int runs){
+    double serialMs = 0.0, overlappedMs = 0.0;
+    BumpAllocator warmup = make_bump_allocator(MB(16));
+    SM_ASSERT_GUARD(bench_load_startup_assets(&warmup), , "Failed to load the startup assets");
+    free(warmup.memory);
+
+    for(int run = 0; run < runs; run++){
+        double start = bench_now_ms();
+        BumpAllocator transientStorage = bench_make_zeroed_allocator(MB(50));
+        BumpAllocator persistentStorage = bench_make_zeroed_allocator(MB(50));
+        bench_init_startup_state(&persistentStorage);
+        bench_load_startup_assets(&transientStorage);
+        serialMs += bench_now_ms() - start;
+        free(transientStorage.memory);
+        free(persistentStorage.memory);
+
+        start = bench_now_ms();
+        transientStorage = make_bump_allocator(MB(50));
+        persistentStorage = make_bump_allocator(MB(50));
+        BumpAllocator startupStorage = make_bump_allocator(MB(16));
+        std::thread assetLoader([&](){ bench_load_startup_assets(&startupStorage); });
+        bench_init_startup_state(&persistentStorage);
+        assetLoader.join();
+        overlappedMs += bench_now_ms() - start;
+        free(transientStorage.memory);
+        free(persistentStorage.memory);
+        free(startupStorage.memory);
+    }
+    SM_TRACE("startup serial %7.3f ms, overlapped %7.3f ms (%.2fx), before the window and GL", serialMs / runs,
+             overlappedMs / runs, serialMs / overlappedMs);
+    bench_record("ms", serialMs / runs, "startup/serial");
+    bench_record("ms", overlappedMs / runs, "startup/overlapped");
+}
+
+// bench.exe [results.json] [baseline.json] [thresholdPercent]
+// Runs every bench and writes what they recorded to the results file. With a baseline, every result that got more
+// than thresholdPercent slower than the one of the same name in there is reported, as is every name that is only in
+// one of the two files. The exit code is their count. A results file of a known good build is a baseline as is.
+int main(int argc, char** argv){
+    const char* resultsPath = argc > 1 ? argv[1] : "bench_results.json";
+    char* baselinePath = argc > 2 ? argv[2] : nullptr;
+    double thresholdPercent = argc > 3 ? atof(argv[3]) : BENCH_REGRESSION_THRESHOLD;
+
+    BumpAllocator benchStorage = make_bump_allocator(MB(256));
+    BumpAllocator persistentStorage = make_bump_allocator(MB(50));
+    BumpAllocator transientStorage = make_bump_allocator(MB(50));
+    renderData = (RenderData*)bump_alloc(&persistentStorage, sizeof(RenderData));
+    particleSystem = (ParticleSystem*)bump_alloc(&persistentStorage, sizeof(ParticleSystem));
+    input = (Input*)bump_alloc(&persistentStorage, sizeof(Input));
+    renderData->gameCamera.dimensions = {WORLD_WIDTH, WORLD_HEIGHT};
+    renderData->gameCamera.position = {160, -90};
+    input->screenSize = {WORLD_WIDTH * 4, WORLD_HEIGHT * 4};
+    SM_ASSERT_GUARD(sw_init(&persistentStorage, WORLD_WIDTH, WORLD_HEIGHT), -1, "Failed to initialize the Software Renderer");
+
+    bench_core(&benchStorage, 1 << 24);
+
+    int entityCounts[] = {1000, 10000, 100000, 1000000};
+    for(int idx = 0; idx < (int)(sizeof(entityCounts) / sizeof(entityCounts[0])); idx++){
+        bench_spatial_hash(&benchStorage, entityCounts[idx]);
+    }
+
+    int particleCounts[] = {50000, 100000, 200000};
+    for(int idx = 0; idx < (int)(sizeof(particleCounts) / sizeof(particleCounts[0])); idx++){
+        bench_particles(particleCounts[idx]);
+    }
+
+    bench_sprite_emission(&benchStorage, 100000);
+    bench_math(&benchStorage, 1000000);
+    bench_text(&benchStorage, 250, 80);
+    bench_animations(&benchStorage, 100000);
+    bench_level(&benchStorage, {4096, 4096});
+
+    bench_rewind(&benchStorage, "game_state", sizeof(GameState), 16, REWIND_FRAMES, REWIND_DATA_SIZE);
+    bench_rewind(&benchStorage, "256kb", KB(256), 512, REWIND_FRAMES, MB(16));
+
+    bench_sprite_scene(&benchStorage, &transientStorage, 100000, 100);
+    bench_scenes(&benchStorage, &transientStorage, {1024, 1024}, BENCH_SCENE_FRAMES);
+
+    bench_batch_simulation(&benchStorage, 4096, 64, 600);
+    bench_batch_simulation(&benchStorage, 16384, 64, 600);
+
+    bench_startup(20);
+
+    bench_write_results(resultsPath);
+    return baselinePath ? bench_compare_results(baselinePath, thresholdPercent, &benchStorage) : 0;
+}
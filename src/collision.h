@@ -0,0 +1,115 @@
+#pragma once
+#include "engine_lib.h"
+#include "assets.h"
+#include "animation.h"
+#include "world.h"
+
+//#####################################################################################################################################
+//                                                  Collision Constants
+//#####################################################################################################################################
+constexpr int MAX_COLLISION_MASK_WORDS = 16;    // per row, masks up to 1024 pixels wide
+
+//#####################################################################################################################################
+//                                                  Collision Structs
+//#####################################################################################################################################
+// One bit per pixel, rows from the top. Bit n of word w in a row is pixel w * 64 + n, so the leftmost pixel is the
+// lowest bit and bits past size.x are always 0
+struct CollisionMask{
+    IVec2 size;
+    int wordsPerRow;
+    int firstWord;              // row y starts at COLLISION_MASK_WORDS[firstWord + y * wordsPerRow]
+};
+
+// COLLISION_MASK_WORDS and the mask tables, written by tools/collision_bake.cpp from the alpha of the atlas pages
+#include "collision_generated.h"
+
+//#####################################################################################################################################
+//                                                  Collision Functions
+//#####################################################################################################################################
+CollisionMask get_collision_mask(SpriteID spriteID){
+    SM_ASSERT(spriteID >= 0 && spriteID < SPRITE_COUNT, "Invalid SpriteID %d", spriteID);
+    return SPRITE_COLLISION_MASKS[spriteID];
+}
+
+CollisionMask get_collision_mask(PackedSpriteID spriteID){
+    SM_ASSERT(spriteID >= 0 && spriteID < PACKED_SPRITE_COUNT, "Invalid PackedSpriteID %d", spriteID);
+    return PACKED_SPRITE_COLLISION_MASKS[spriteID];
+}
+
+CollisionMask get_collision_mask(AnimationState state){
+    return ANIMATION_FRAME_COLLISION_MASKS[get_animation_frame_index(state)];
+}
+
+const unsigned long long* get_mask_row(CollisionMask mask, int y){
+    return &COLLISION_MASK_WORDS[mask.firstWord + y * mask.wordsPerRow];
+}
+
+// The 64 pixels starting at x as one word, x >= 0. Pixels past the end of the row read as 0
+unsigned long long read_mask_bits(const unsigned long long* row, int wordsPerRow, int x){
+    int word = x >> 6, shift = x & 63;
+    if(word >= wordsPerRow) return 0;
+    unsigned long long bits = row[word] >> shift;
+    if(shift && word + 1 < wordsPerRow) bits |= row[word + 1] << (64 - shift);
+    return bits;
+}
+
+// Sets pixels [start, end) of a row
+void set_mask_span(unsigned long long* row, int start, int end){
+    for(int x = start; x < end;){
+        int bit = x & 63;
+        int count = min(64 - bit, end - x);
+        row[x >> 6] |= (count == 64 ? ~0ull : (1ull << count) - 1) << bit;
+        x += count;
+    }
+}
+
+// Masks placed with their top-left corner at posA and posB in world pixels. Only the overlap of the two rects is
+// tested, 64 pixels of one row at a time
+bool masks_overlap(CollisionMask a, IVec2 posA, CollisionMask b, IVec2 posB){
+    int minX = max(posA.x, posB.x), maxX = min(posA.x + a.size.x, posB.x + b.size.x);
+    int minY = max(posA.y, posB.y), maxY = min(posA.y + a.size.y, posB.y + b.size.y);
+    if(minX >= maxX || minY >= maxY) return false;
+
+    for(int y = minY; y < maxY; y++){
+        const unsigned long long* rowA = get_mask_row(a, y - posA.y);
+        const unsigned long long* rowB = get_mask_row(b, y - posB.y);
+        for(int x = minX; x < maxX; x += 64){
+            unsigned long long bits = read_mask_bits(rowA, a.wordsPerRow, x - posA.x) & read_mask_bits(rowB, b.wordsPerRow, x - posB.x);
+            if(maxX - x < 64) bits &= (1ull << (maxX - x)) - 1;
+            if(bits) return true;
+        }
+    }
+    return false;
+}
+
+// Mask placed with its top-left corner at pos in world pixels against the visible tiles of the world. Tiles outside
+// the world or not streamed in count as solid. Every band of rows that lies in one row of tiles shares a solid mask
+// built from those tiles
+bool mask_overlaps_tiles(ChunkWorld* world, CollisionMask mask, IVec2 pos, int tileSize){
+    SM_ASSERT_GUARD(mask.wordsPerRow <= MAX_COLLISION_MASK_WORDS, false, "Collision Mask is %d pixels wide, at most %d are supported",
+                    mask.size.x, MAX_COLLISION_MASK_WORDS * 64);
+    if(mask.size.x <= 0 || mask.size.y <= 0) return false;
+    int tileMinX = floor_div(pos.x, tileSize), tileMaxX = floor_div(pos.x + mask.size.x - 1, tileSize);
+    int tileMinY = floor_div(pos.y, tileSize), tileMaxY = floor_div(pos.y + mask.size.y - 1, tileSize);
+
+    for(int tileY = tileMinY; tileY <= tileMaxY; tileY++){
+        unsigned long long solid[MAX_COLLISION_MASK_WORDS] = {};
+        bool anySolid = false;
+        for(int tileX = tileMinX; tileX <= tileMaxX; tileX++){
+            Tile* tile = get_world_tile(world, tileX, tileY);
+            if(tile && !tile->isVisible) continue;
+            set_mask_span(solid, max(0, tileX * tileSize - pos.x), min(mask.size.x, (tileX + 1) * tileSize - pos.x));
+            anySolid = true;
+        }
+        if(!anySolid) continue;
+
+        int rowStart = max(0, tileY * tileSize - pos.y), rowEnd = min(mask.size.y, (tileY + 1) * tileSize - pos.y);
+        for(int y = rowStart; y < rowEnd; y++){
+            const unsigned long long* row = get_mask_row(mask, y);
+            for(int word = 0; word < mask.wordsPerRow; word++){
+                if(row[word] & solid[word]) return true;
+            }
+        }
+    }
+    return false;
+}
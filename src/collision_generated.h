@@ -0,0 +1,136 @@
+#pragma once
+// Generated by tools/collision_bake.cpp from the alpha of the atlas pages, edit the sprites instead
+
+constexpr unsigned long long COLLISION_MASK_WORDS[] = {
+    // SpriteID 0
+    0x0000000000000001ull,
+    // SpriteID 1
+    0x0000000000000000ull,
+    0x00000000000003c0ull,
+    0x0000000000000ff0ull,
+    0x0000000000003ffcull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000003ffcull,
+    0x0000000000000ff0ull,
+    0x00000000000003c0ull,
+    0x0000000000000000ull,
+    // SpriteID 2
+    0x0000000000000000ull,
+    0x00000000000003c0ull,
+    0x0000000000000ff0ull,
+    0x0000000000003ffcull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000003ffcull,
+    0x0000000000000ff0ull,
+    0x00000000000003c0ull,
+    0x0000000000000000ull,
+    // SpriteID 3
+    0x4000001422165520ull,
+    0x4000252225437520ull,
+    0x2070722202225020ull,
+    0x1002252205167000ull,
+    0x1201001406435020ull,
+    0x0000000000000000ull,
+    0x3104007776753327ull,
+    0x4272225541154435ull,
+    0x2401007727372225ull,
+    0x0272224525444125ull,
+    0x2104103727343777ull,
+    0x0000000000000000ull,
+    0x2351547567736322ull,
+    0x5571542511151555ull,
+    0x5571342753351375ull,
+    0x5551552551151551ull,
+    0x2557527561736356ull,
+    0x0000000000000000ull,
+    0x0261375555576323ull,
+    0x0541145555521555ull,
+    0x0042122275522353ull,
+    0x0044112572524531ull,
+    0x7064372552623561ull,
+    0x0000000000000000ull,
+    0x2351547567736321ull,
+    0x5571542511151552ull,
+    0x5571342753351370ull,
+    0x5551552551151550ull,
+    0x2557527561736350ull,
+    0x0000000000000000ull,
+    0x0032675555576323ull,
+    0x0322245555521555ull,
+    0x0662322275522353ull,
+    0x0022212572524531ull,
+    0x0032672552623561ull,
+    0x0000000000000000ull,
+    // PackedSpriteID 0
+    0x0000000000000048ull,
+    0x000000000000006cull,
+    0x000000000000007eull,
+    0x000000000000006cull,
+    0x0000000000000048ull,
+    // ANIMATION_FRAMES[0]
+    0x0000000000000000ull,
+    0x00000000000003c0ull,
+    0x0000000000000ff0ull,
+    0x0000000000003ffcull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000003ffcull,
+    0x0000000000000ff0ull,
+    0x00000000000003c0ull,
+    0x0000000000000000ull,
+    // ANIMATION_FRAMES[1]
+    0x0000000000000000ull,
+    0x00000000000003c0ull,
+    0x0000000000000ff0ull,
+    0x0000000000003ffcull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000007ffeull,
+    0x0000000000003ffcull,
+    0x0000000000000ff0ull,
+    0x00000000000003c0ull,
+    0x0000000000000000ull,
+};
+
+constexpr int ANIMATION_FRAME_COUNT = 2;
+
+constexpr CollisionMask SPRITE_COLLISION_MASKS[(SPRITE_COUNT > 0 ? SPRITE_COUNT : 1)] = {
+    {{1, 1}, 1, 0},      // SpriteID 0
+    {{16, 16}, 1, 1},      // SpriteID 1
+    {{16, 16}, 1, 17},      // SpriteID 2
+    {{64, 36}, 1, 33},      // SpriteID 3
+};
+
+constexpr CollisionMask PACKED_SPRITE_COLLISION_MASKS[(PACKED_SPRITE_COUNT > 0 ? PACKED_SPRITE_COUNT : 1)] = {
+    {{7, 5}, 1, 69},      // PackedSpriteID 0
+};
+
+constexpr CollisionMask ANIMATION_FRAME_COLLISION_MASKS[(ANIMATION_FRAME_COUNT > 0 ? ANIMATION_FRAME_COUNT : 1)] = {
+    {{16, 16}, 1, 74},      // ANIMATION_FRAMES[0]
+    {{16, 16}, 1, 90},      // ANIMATION_FRAMES[1]
+};
@@ -4,6 +4,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 //#####################################################################################################################################
 //                                                  Defines
 //#####################################################################################################################################
@@ -36,8 +40,8 @@ enum TextColor{
 
 template <typename ...Args>
 
-void _log(char* prefix, char* msg, TextColor textColor, Args ...args){
-    static char* TextColorTable[TextColor::TEXT_COLOR_COUNT] = {
+void _log(const char* prefix, const char* msg, TextColor textColor, Args ...args){
+    static const char* TextColorTable[TextColor::TEXT_COLOR_COUNT] = {
         "\x1b[30m", "\x1b[31m", "\x1b[32m", "\x1b[33m", "\x1b[34m", "\x1b[35m", "\x1b[36m", "\x1b[37m",
         "\x1b[90m", "\x1b[91m", "\x1b[92m", "\x1b[93m", "\x1b[94m", "\x1b[95m", "\x1b[96m", "\x1b[97m",
     };
@@ -92,6 +96,14 @@ struct Array{
         SM_ASSERT(idx < count, "index is out of bounds");
         element[idx] = element[--count];
     }
+    // Claims n consecutive elements at the end and returns the first one, the caller fills them in place
+    T* push(int n){
+        SM_ASSERT(n >= 0, "push count is negative");
+        SM_ASSERT(count + n <= maxElements, "Array is full");
+        T* result = &elements[count];
+        count += n;
+        return result;
+    }
     void clear(){ count = 0; }
     bool is_full(){ return count ==N; }
 };
@@ -104,12 +116,12 @@ struct BumpAllocator{
     char* memory;
 };
 
+// calloc gets zeroed pages from the OS on first touch, a memset would touch all of them up front
 BumpAllocator make_bump_allocator(size_t size){
     BumpAllocator ba = {};
-    ba.memory = (char*)malloc(size);
+    ba.memory = (char*)calloc(1, size);
     SM_ASSERT(ba.memory, "Failed to allocate Memory!");
     ba.capacity = size;
-    memset(ba.memory, 0, size);
     return ba;
 }
 
@@ -133,7 +145,7 @@ long long get_timestamp(const char* file){
     return file_stat.st_mtime;
 }
 
-bool file_exists(char* filepath){
+bool file_exists(const char* filepath){
     SM_ASSERT(filepath, "No file Path supplied!");
     auto file = fopen(filepath, "rb");
     if(!file)return false;
@@ -141,7 +153,7 @@ bool file_exists(char* filepath){
     return true;
 }
 
-long get_file_size(char* filepath){
+long get_file_size(const char* filepath){
     SM_ASSERT(filepath, "No file Path supplied!");
     long fileSize = 0;
     auto file = fopen(filepath, "rb");
@@ -156,7 +168,7 @@ long get_file_size(char* filepath){
     return fileSize;
 }
 
-char* read_file(char* filepath, int* fileSize, char* buffer){
+char* read_file(const char* filepath, int* fileSize, char* buffer){
     SM_ASSERT(filepath, "No file Path supplied!");
     SM_ASSERT(fileSize, "No file Size supplied!");
     SM_ASSERT(buffer, "No buffer supplied!");
@@ -175,7 +187,7 @@ char* read_file(char* filepath, int* fileSize, char* buffer){
     return buffer;
 }
 
-char* read_file(char* filepath, int* fileSize, BumpAllocator* bumpAllocator){
+char* read_file(const char* filepath, int* fileSize, BumpAllocator* bumpAllocator){
     char* file = nullptr;
     long _fileSize = get_file_size(filepath);
     if (!_fileSize) return file;
@@ -196,6 +208,30 @@ void write_file(char* filepath, char* buffer, int size){
     fclose(file);
 }
 
+// Opens path.tmp for writing, finish_file_replace moves it over path once everything is in it. A tool that fails
+// halfway leaves the last good file in place instead of a truncated one
+FILE* begin_file_replace(const char* path){
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    auto file = fopen(tmpPath, "wb");
+    if(!file) SM_ERROR("Failed opening File: %s", tmpPath);
+    return file;
+}
+
+// Closes the file from begin_file_replace, then replaces path with it if written is true and deletes it otherwise
+bool finish_file_replace(FILE* file, const char* path, bool written){
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    bool result = fclose(file) == 0 && written;
+    if(result){
+        remove(path);
+        result = rename(tmpPath, path) == 0;
+        if(!result) SM_ERROR("Failed replacing File: %s", path);
+    }
+    if(!result) remove(tmpPath);
+    return result;
+}
+
 bool copy_file(char* filename, char* outputName, char* buffer){
     int fileSize = 0;
     char* data = read_file(filename, &fileSize, buffer);
@@ -215,30 +251,74 @@ bool copy_file(char* filename, char* outputName, char* buffer){
 }
 
 bool copy_file(char* filename, char* outputName, BumpAllocator* bumpAllocator){
-    char* file = 0;
     long _fileSize = get_file_size(filename);
     if(!_fileSize) return false;
     char* buffer = bump_alloc(bumpAllocator, _fileSize+1);
     return copy_file(filename, outputName, buffer);
 }
 
+// Creates every missing directory along the path, returns true if the directory exists afterwards
+bool create_directory(const char* path){
+    SM_ASSERT(path, "No directory Path supplied!");
+    char buffer[512] = {};
+    int length = (int)strlen(path);
+    SM_ASSERT_GUARD(length < (int)sizeof(buffer), false, "Directory Path is too long: %s", path);
+    memcpy(buffer, path, length);
+
+    for(int idx = 1; idx <= length; idx++){
+        if(buffer[idx] != '/' && buffer[idx] != '\\' && buffer[idx] != 0) continue;
+        char separator = buffer[idx];
+        buffer[idx] = 0;
+#ifdef _WIN32
+        int result = _mkdir(buffer);
+#else
+        int result = mkdir(buffer, 0755);
+#endif
+        if(result != 0 && errno != EEXIST){
+            SM_ERROR("Failed creating Directory: %s", buffer);
+            return false;
+        }
+        buffer[idx] = separator;
+    }
+    return true;
+}
+
 
 //#####################################################################################################################################
 //                                                  Math stuff
 //#####################################################################################################################################
 long long max(long long a, long long b){ return (a > b)? a:b; }
+int max(int a, int b){ return (a > b)? a:b; }
+int min(int a, int b){ return (a < b)? a:b; }
+float min(float a, float b){ return (a < b)? a:b; }
+float max(float a, float b){ return (a > b)? a:b; }
+
+// Rounds towards negative infinity, world coordinates left/above the origin map to negative cells
+int floor_div(int value, int divisor){
+    int result = value / divisor;
+    if((value % divisor != 0) && ((value < 0) != (divisor < 0))) result--;
+    return result;
+}
 
 struct Vec2{ 
     float x, y; 
-    Vec2 operator/(float scalar){ return {x / scalar, y / scalar};}
-    Vec2 operator-(Vec2 other){return {x - other.x, y - other.y};}
+    constexpr Vec2 operator/(float scalar) const { return {x / scalar, y / scalar};}
+    constexpr Vec2 operator*(float scalar) const { return {x * scalar, y * scalar};}
+    constexpr Vec2 operator+(Vec2 other) const {return {x + other.x, y + other.y};}
+    constexpr Vec2 operator-(Vec2 other) const {return {x - other.x, y - other.y};}
+    constexpr Vec2 operator*(Vec2 other) const {return {x * other.x, y * other.y};}
+    Vec2& operator+=(Vec2 other){ x += other.x; y += other.y; return *this;}
+    Vec2& operator-=(Vec2 other){ x -= other.x; y -= other.y; return *this;}
 };
 
 struct IVec2{ 
     int x, y;
-    IVec2 operator-(IVec2 other){return {x - other.x, y - other.y};}
+    constexpr IVec2 operator+(IVec2 other) const {return {x + other.x, y + other.y};}
+    constexpr IVec2 operator-(IVec2 other) const {return {x - other.x, y - other.y};}
+    constexpr IVec2 operator*(int scalar) const {return {x * scalar, y * scalar};}
+    constexpr bool operator==(IVec2 other) const {return x == other.x && y == other.y;}
 };
-Vec2 vec_2(IVec2 v) {return Vec2{(float)v.x, (float)v.y};}
+constexpr Vec2 vec_2(IVec2 v) {return Vec2{(float)v.x, (float)v.y};}
 
 struct Vec3{
     union{
@@ -0,0 +1,169 @@
+#pragma once
+#include "engine_lib.h"
+#include "game.h"
+
+#include <atomic>
+#include <thread>
+
+//#####################################################################################################################################
+//                                                  Frame Capture Constants
+//#####################################################################################################################################
+constexpr int CAPTURE_QUEUE_SIZE = 8;
+constexpr int CAPTURE_FRAME_RATE = (int)(1.0f / FRAME_TIME + 0.5f);    // every update is one frame of video
+
+//#####################################################################################################################################
+//                                                  Frame Capture Structs
+//#####################################################################################################################################
+enum CaptureFormat{
+    CAPTURE_FORMAT_Y4M,     // one raw 4:4:4 video file, ffmpeg and mpv read it as is
+    CAPTURE_FORMAT_PPM,     // a directory of frame_<n>.ppm, the same files headless.exe always wrote
+};
+
+// Single producer (the renderer) and single consumer (the writer thread). Frames are RGBA8, R in the lowest byte,
+// rows from the top. Every frame of a capture has the size it was started with
+struct FrameCapture{
+    CaptureFormat format;
+    char path[256];
+    FILE* file;
+    IVec2 size;
+    bool dropWhenFull;          // the game never waits for the writer, headless runs wait instead
+
+    BumpAllocator storage;
+    unsigned int* frames[CAPTURE_QUEUE_SIZE];
+    unsigned char* scratch;     // writer thread only, one frame converted to the output format
+    std::atomic<int> head;
+    std::atomic<int> tail;
+
+    std::thread writer;
+    std::atomic<bool> running;
+    int writtenFrames, droppedFrames;
+};
+
+//#####################################################################################################################################
+//                                                  Frame Capture Globals
+//#####################################################################################################################################
+static FrameCapture frameCapture;
+
+//#####################################################################################################################################
+//                                                  Frame Capture Functions
+//#####################################################################################################################################
+// BT.601 limited range, what players assume for Y4M without a color space tag
+void write_capture_y4m(FrameCapture* capture, unsigned int* pixels){
+    int pixelCount = capture->size.x * capture->size.y;
+    unsigned char* y = capture->scratch;
+    unsigned char* u = y + pixelCount;
+    unsigned char* v = u + pixelCount;
+    for(int idx = 0; idx < pixelCount; idx++){
+        int r = pixels[idx] & 0xFF, g = (pixels[idx] >> 8) & 0xFF, b = (pixels[idx] >> 16) & 0xFF;
+        y[idx] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[idx] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[idx] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    fwrite("FRAME\n", 1, 6, capture->file);
+    fwrite(capture->scratch, 1, pixelCount * 3, capture->file);
+}
+
+void write_capture_ppm(FrameCapture* capture, unsigned int* pixels){
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", capture->size.x, capture->size.y);
+    int pixelCount = capture->size.x * capture->size.y;
+    memcpy(capture->scratch, header, headerSize);
+    unsigned char* rgb = capture->scratch + headerSize;
+    for(int idx = 0; idx < pixelCount; idx++){
+        *rgb++ = pixels[idx] & 0xFF;
+        *rgb++ = (pixels[idx] >> 8) & 0xFF;
+        *rgb++ = (pixels[idx] >> 16) & 0xFF;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%05d.ppm", capture->path, capture->writtenFrames);
+    write_file(path, (char*)capture->scratch, headerSize + pixelCount * 3);
+}
+
+// Writer thread, drains the queue before it stops
+void run_capture_writer(FrameCapture* capture){
+    while(true){
+        int head = capture->head.load(std::memory_order_relaxed);
+        if(head == capture->tail.load(std::memory_order_acquire)){
+            if(!capture->running.load(std::memory_order_acquire)) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        unsigned int* pixels = capture->frames[head % CAPTURE_QUEUE_SIZE];
+        if(capture->format == CAPTURE_FORMAT_Y4M) write_capture_y4m(capture, pixels);
+        else write_capture_ppm(capture, pixels);
+        capture->writtenFrames++;
+        capture->head.store(head + 1, std::memory_order_release);
+    }
+}
+
+// *.y4m records a video, anything else is a directory that gets one PPM per frame
+bool start_frame_capture(const char* path, IVec2 size, bool dropWhenFull){
+    FrameCapture* capture = &frameCapture;
+    SM_ASSERT_GUARD(!capture->running, false, "A Frame Capture is already running");
+    SM_ASSERT_GUARD(size.x > 0 && size.y > 0, false, "Can not capture %dx%d frames", size.x, size.y);
+    int length = (int)strlen(path);
+    capture->format = length > 4 && strcmp(path + length - 4, ".y4m") == 0 ? CAPTURE_FORMAT_Y4M : CAPTURE_FORMAT_PPM;
+    snprintf(capture->path, sizeof(capture->path), "%s", path);
+    capture->size = size;
+    capture->dropWhenFull = dropWhenFull;
+    capture->writtenFrames = 0;
+    capture->droppedFrames = 0;
+
+    if(capture->format == CAPTURE_FORMAT_Y4M){
+        capture->file = fopen(path, "wb");
+        SM_ASSERT_GUARD(capture->file, false, "Failed to open Capture file: %s", path);
+        fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", size.x, size.y, CAPTURE_FRAME_RATE);
+    } else {
+        SM_ASSERT_GUARD(create_directory(path), false, "Failed to create Capture directory: %s", path);
+    }
+
+    size_t frameSize = sizeof(unsigned int) * size.x * size.y;
+    size_t scratchSize = (size_t)size.x * size.y * 3 + 64;
+    capture->storage = make_bump_allocator(frameSize * CAPTURE_QUEUE_SIZE + scratchSize + 8 * (CAPTURE_QUEUE_SIZE + 1));
+    for(int idx = 0; idx < CAPTURE_QUEUE_SIZE; idx++) capture->frames[idx] = (unsigned int*)bump_alloc(&capture->storage, frameSize);
+    capture->scratch = (unsigned char*)bump_alloc(&capture->storage, scratchSize);
+    capture->head.store(0, std::memory_order_relaxed);
+    capture->tail.store(0, std::memory_order_relaxed);
+
+    capture->running.store(true, std::memory_order_release);
+    capture->writer = std::thread(run_capture_writer, capture);
+    SM_TRACE("Capturing %dx%d frames into %s", size.x, size.y, path);
+    return true;
+}
+
+// Pixels to fill for the next frame, nullptr if the frame is dropped. Pair with submit_capture_frame
+unsigned int* begin_capture_frame(IVec2 size){
+    FrameCapture* capture = &frameCapture;
+    if(!capture->running.load(std::memory_order_relaxed)) return nullptr;
+    if(!(size == capture->size)){
+        capture->droppedFrames++;
+        return nullptr;
+    }
+    int tail = capture->tail.load(std::memory_order_relaxed);
+    while(tail - capture->head.load(std::memory_order_acquire) == CAPTURE_QUEUE_SIZE){
+        if(capture->dropWhenFull){
+            capture->droppedFrames++;
+            return nullptr;
+        }
+        std::this_thread::yield();
+    }
+    return capture->frames[tail % CAPTURE_QUEUE_SIZE];
+}
+
+void submit_capture_frame(){
+    frameCapture.tail.fetch_add(1, std::memory_order_release);
+}
+
+// Waits for the writer to catch up with every submitted frame
+void stop_frame_capture(){
+    FrameCapture* capture = &frameCapture;
+    if(!capture->running) return;
+    capture->running.store(false, std::memory_order_release);
+    capture->writer.join();
+    if(capture->file) fclose(capture->file);
+    capture->file = nullptr;
+    free(capture->storage.memory);
+    capture->storage = {};
+    if(capture->droppedFrames) SM_WARN("Dropped %d Frames while capturing", capture->droppedFrames);
+    SM_TRACE("Captured %d frames into %s", capture->writtenFrames, capture->path);
+}
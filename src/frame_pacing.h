@@ -0,0 +1,213 @@
+#pragma once
+#include "engine_lib.h"
+#include "platform.h"
+#include "game.h"
+
+//#####################################################################################################################################
+//                                                  Frame Pacing Constants
+//#####################################################################################################################################
+constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+constexpr int FRAME_FENCE_SLOTS = MAX_FRAMES_IN_FLIGHT + 1;  // one extra for the frame submitted before the oldest is waited on
+constexpr int FRAME_TIMING_HISTORY = 256;
+constexpr long long FRAME_PACING_INITIAL_OVERSHOOT_NS = 1000000;   // wake up this early until the real overshoot is known
+constexpr long long FRAME_PACING_FENCE_TIMEOUT_NS = 100000000;     // a GPU that takes longer than this has bigger problems
+constexpr long long FRAME_PACING_LOG_INTERVAL_NS = 1000000000;
+
+//#####################################################################################################################################
+//                                                  Frame Pacing Structs
+//#####################################################################################################################################
+enum VSyncMode{
+    VSYNC_OFF,
+    VSYNC_ON,
+    VSYNC_ADAPTIVE,  // waits for vblank, late frames are presented right away and tear instead of waiting for the next one
+    VSYNC_COUNT
+};
+
+struct FramePacingConfig{
+    VSyncMode vsync = VSYNC_ADAPTIVE;
+    // The simulation steps FRAME_TIME per frame, so the cap is the game speed as well. 0 leaves pacing to vsync
+    float targetFrameTime = FRAME_TIME;
+    // Frames the CPU may submit before waiting on the GPU, more smooths out spikes but adds a frame of latency each
+    int framesInFlight = 2;
+    bool logTimings = false;
+};
+
+// Everything in milliseconds, latencyMs is filled in once the GPU is done with the frame and stays 0 until then
+struct FrameTiming{
+    int frame;
+    float frameMs, workMs, sleepMs, spinMs, fenceWaitMs, latencyMs;
+};
+
+struct FrameFence{
+    GLsync fence;
+    int frame;
+    long long inputTimeNs;
+};
+
+struct FramePacer{
+    FramePacingConfig config;
+    VSyncMode vsync;
+
+    // Oldest first
+    FrameFence fences[FRAME_FENCE_SLOTS];
+    int fenceFirst, fenceCount;
+
+    long long nextFrameNs, frameStartNs, inputTimeNs;
+    long long sleepOvershootNs;
+    int frame;
+
+    // Indexed by frame % FRAME_TIMING_HISTORY
+    FrameTiming history[FRAME_TIMING_HISTORY];
+
+    long long lastLogNs;
+    int loggedFrame;
+};
+
+//#####################################################################################################################################
+//                                                  Frame Pacing Globals
+//#####################################################################################################################################
+static FramePacer framePacer;
+
+//#####################################################################################################################################
+//                                                  Frame Pacing Functions
+//#####################################################################################################################################
+FrameTiming* get_frame_timing(int frame){
+    return &framePacer.history[frame % FRAME_TIMING_HISTORY];
+}
+
+// Adaptive falls back to regular vsync on drivers without WGL_EXT_swap_control_tear
+void set_vsync_mode(VSyncMode mode){
+    int intervals[VSYNC_COUNT] = {0, 1, -1};
+    if(mode == VSYNC_ADAPTIVE && !platform_set_swap_interval(intervals[mode])){
+        SM_WARN("Adaptive VSync is not supported, falling back to VSync");
+        mode = VSYNC_ON;
+    }
+    if(mode != VSYNC_ADAPTIVE && !platform_set_swap_interval(intervals[mode])){
+        SM_WARN("Failed to set the swap interval, VSync is left to the driver");
+    }
+    framePacer.vsync = mode;
+    framePacer.config.vsync = mode;
+
+    const char* names[VSYNC_COUNT] = {"Off", "On", "Adaptive"};
+    SM_TRACE("VSync: %s", names[mode]);
+}
+
+void init_frame_pacer(FramePacingConfig config){
+    config.framesInFlight = max(1, min(config.framesInFlight, MAX_FRAMES_IN_FLIGHT));
+    framePacer = {};
+    framePacer.config = config;
+    framePacer.sleepOvershootNs = FRAME_PACING_INITIAL_OVERSHOOT_NS;
+    set_vsync_mode(config.vsync);
+}
+
+// Right before input is sampled. Sleeps until shortly before the frame is due and spins the rest, the sleep is
+// woken up early by the largest overshoot seen recently so a late wake up rarely costs a frame
+void begin_frame(){
+    long long now = platform_get_time_ns();
+    long long waitStartNs = now;
+    long long targetNs = (long long)(framePacer.config.targetFrameTime * 1000000000.0);
+    FrameTiming* timing = get_frame_timing(framePacer.frame);
+    *timing = {};
+    timing->frame = framePacer.frame;
+
+    if(targetNs > 0 && framePacer.nextFrameNs){
+        long long sleepNs = framePacer.nextFrameNs - now - framePacer.sleepOvershootNs;
+        if(sleepNs > 0){
+            platform_sleep_ns(sleepNs);
+            long long wokeNs = platform_get_time_ns();
+            long long overshootNs = (wokeNs - now) - sleepNs;
+            // Jumps up to a new worst case right away and decays slowly, waking too late costs more than spinning
+            if(overshootNs > framePacer.sleepOvershootNs) framePacer.sleepOvershootNs = overshootNs;
+            else framePacer.sleepOvershootNs += (overshootNs - framePacer.sleepOvershootNs) / 16;
+            if(framePacer.sleepOvershootNs > targetNs / 2) framePacer.sleepOvershootNs = targetNs / 2;
+            if(framePacer.sleepOvershootNs < 0) framePacer.sleepOvershootNs = 0;
+            now = wokeNs;
+        }
+        timing->sleepMs = (now - waitStartNs) / 1000000.0f;
+
+        long long spinStartNs = now;
+        while(now < framePacer.nextFrameNs) now = platform_get_time_ns();
+        timing->spinMs = (now - spinStartNs) / 1000000.0f;
+    }
+
+    // Scheduled from the deadline rather than from now so wake up jitter does not add up. A frame that missed its
+    // deadline by a whole frame restarts the schedule instead of running the next few back to back to catch up
+    bool onSchedule = framePacer.nextFrameNs && now - framePacer.nextFrameNs < targetNs;
+    timing->frameMs = framePacer.frameStartNs ? (now - framePacer.frameStartNs) / 1000000.0f : 0.0f;
+    framePacer.nextFrameNs = onSchedule ? framePacer.nextFrameNs + targetNs : now + targetNs;
+    framePacer.frameStartNs = now;
+    framePacer.inputTimeNs = now;
+}
+
+void log_frame_timings(long long now){
+    int frameCount = min(framePacer.frame - framePacer.loggedFrame, FRAME_TIMING_HISTORY);
+    float frameSum = 0.0f, frameMax = 0.0f, latencySum = 0.0f, latencyMax = 0.0f, fenceWaitSum = 0.0f;
+    int latencyCount = 0;
+    for(int frame = framePacer.frame - frameCount; frame < framePacer.frame; frame++){
+        FrameTiming* timing = get_frame_timing(frame);
+        frameSum += timing->frameMs;
+        frameMax = max(frameMax, timing->frameMs);
+        fenceWaitSum += timing->fenceWaitMs;
+        if(timing->latencyMs > 0.0f){
+            latencySum += timing->latencyMs;
+            latencyMax = max(latencyMax, timing->latencyMs);
+            latencyCount++;
+        }
+    }
+    if(frameCount){
+        float seconds = (now - framePacer.lastLogNs) / 1000000000.0f;
+        SM_TRACE("%.1f fps, frame %.2f ms (max %.2f), latency %.2f ms (max %.2f), fence wait %.2f ms",
+                 frameCount / seconds, frameSum / frameCount, frameMax,
+                 latencyCount ? latencySum / latencyCount : 0.0f, latencyMax, fenceWaitSum / frameCount);
+    }
+    framePacer.lastLogNs = now;
+    framePacer.loggedFrame = framePacer.frame;
+}
+
+// Right after the swap. Fences the frame and retires the ones the GPU is done with, waiting on the oldest while
+// more than framesInFlight are still queued. The latency runs from input sampling to the fence, which signals
+// once the frame is rendered and queued for presentation, the scan out itself adds up to one more refresh with
+// vsync. Finished fences are only noticed here, so unless the wait blocked the latency is rounded up to a frame
+void end_frame(){
+    long long now = platform_get_time_ns();
+    FrameTiming* timing = get_frame_timing(framePacer.frame);
+    timing->workMs = (now - framePacer.frameStartNs) / 1000000.0f;
+
+    SM_ASSERT(framePacer.fenceCount <= MAX_FRAMES_IN_FLIGHT, "Frame Fence ring is full");
+    FrameFence* frameFence = &framePacer.fences[(framePacer.fenceFirst + framePacer.fenceCount) % FRAME_FENCE_SLOTS];
+    frameFence->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameFence->frame = framePacer.frame;
+    frameFence->inputTimeNs = framePacer.inputTimeNs;
+    framePacer.fenceCount++;
+
+    while(framePacer.fenceCount){
+        FrameFence* oldest = &framePacer.fences[framePacer.fenceFirst];
+        bool mustWait = framePacer.fenceCount > framePacer.config.framesInFlight;
+        long long waitStartNs = platform_get_time_ns();
+        GLenum result = glClientWaitSync(oldest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, mustWait ? FRAME_PACING_FENCE_TIMEOUT_NS : 0);
+        long long signaledNs = platform_get_time_ns();
+        if(mustWait) timing->fenceWaitMs += (signaledNs - waitStartNs) / 1000000.0f;
+
+        if(result == GL_TIMEOUT_EXPIRED){
+            if(!mustWait) break;
+            SM_WARN("Frame %d is still on the GPU after %lld ms", oldest->frame, FRAME_PACING_FENCE_TIMEOUT_NS / 1000000);
+        }
+        else if(result == GL_WAIT_FAILED){
+            SM_ERROR("Failed to wait on the Fence of Frame %d", oldest->frame);
+        }
+        else if(framePacer.frame - oldest->frame < FRAME_TIMING_HISTORY){
+            get_frame_timing(oldest->frame)->latencyMs = (signaledNs - oldest->inputTimeNs) / 1000000.0f;
+        }
+
+        glDeleteSync(oldest->fence);
+        framePacer.fenceFirst = (framePacer.fenceFirst + 1) % FRAME_FENCE_SLOTS;
+        framePacer.fenceCount--;
+    }
+
+    framePacer.frame++;
+    if(!framePacer.config.logTimings || !framePacer.lastLogNs){
+        framePacer.lastLogNs = now;
+        framePacer.loggedFrame = framePacer.frame;
+    }
+    else if(now - framePacer.lastLogNs >= FRAME_PACING_LOG_INTERVAL_NS) log_frame_timings(now);
+}
@@ -11,145 +11,356 @@ static KeyMap maps[] = {{MOVE_UP,    KEY_W}, {MOVE_UP,    KEY_UP},
                         {MOVE_LEFT,  KEY_A}, {MOVE_LEFT,  KEY_LEFT},                   //MoveLeft
                         {MOVE_DOWN,  KEY_S}, {MOVE_DOWN,  KEY_DOWN},                   //MoveDown
                         {MOVE_RIGHT, KEY_D}, {MOVE_RIGHT, KEY_RIGHT},                  //MoveRight
-                        {MOUSE_LEFT, KEY_MOUSE_LEFT}, {MOUSE_RIGHT, KEY_MOUSE_RIGHT}}; //MouseClicks
+                        {MOUSE_LEFT, KEY_MOUSE_LEFT}, {MOUSE_RIGHT, KEY_MOUSE_RIGHT},  //MouseClicks
+                        {MOUSE_MIDDLE, KEY_MOUSE_MIDDLE}};                             //MouseClicks
 //#####################################################################################################################################
 //                                                  Game Structs
 //#####################################################################################################################################
 //#####################################################################################################################################
 //                                                  Game Functions
 //#####################################################################################################################################
-bool just_pressed(GameInputType type){
-    KeyMapping mapping = gameState->keyMappings[type];
+bool just_pressed(GameState* state, Input* in, GameInputType type){
+    KeyMapping mapping = state->keyMappings[type];
     for(int idx = 0; idx < mapping.keys.count; idx++){
-        if(input->keys[mapping.keys[idx]].justPressed) { 
+        if(in->keys[mapping.keys[idx]].justPressed) { 
             return true;
         }
     }
     return false;
 }
 
-bool is_down(GameInputType type){
-    KeyMapping mapping = gameState->keyMappings[type];
+bool is_down(GameState* state, Input* in, GameInputType type){
+    KeyMapping mapping = state->keyMappings[type];
     for(int idx = 0; idx < mapping.keys.count; idx++){
-        if(input->keys[mapping.keys[idx]].isDown) { 
+        if(in->keys[mapping.keys[idx]].isDown) { 
             return true;
         }
     }
     return false;
 }
 
-Tile* get_tile(int x, int y){
-    Tile* tile = nullptr;
-    if(x >=0 && x < WORLD_GRID.x && y >=0 && y < WORLD_GRID.y){
-        tile = &gameState->worldGrid[x][y];
+bool just_pressed(GameInputType type){ return just_pressed(gameState, input, type); }
+
+bool is_down(GameInputType type){ return is_down(gameState, input, type); }
+
+Tile* get_tile(int x, int y){ return get_world_tile(chunkWorld, x, y); }
+
+IVec2 get_tile_pos(IVec2 worldPos){ return {floor_div(worldPos.x, TILESIZE), floor_div(worldPos.y, TILESIZE)}; }
+
+Tile* get_tile(IVec2 worldPos){
+    IVec2 tilePos = get_tile_pos(worldPos);
+    return get_tile(tilePos.x, tilePos.y);
+}
+
+static_assert(TILEMAP_REGION_SIZE == CHUNK_SIZE, "Tilemap regions are uploaded one chunk at a time");
+
+int get_tilemap_index(Tile tile){ return tile.isVisible ? tile.neigbourMask + 1 : 0; }
+
+int get_tilemap_region(IVec2 chunkCoord){
+    return (chunkCoord.y & (TILEMAP_REGIONS - 1)) * TILEMAP_REGIONS + (chunkCoord.x & (TILEMAP_REGIONS - 1));
+}
+
+// Tiles in regions that are not uploaded yet come along with their whole chunk later on
+void upload_tilemap_tile(int x, int y){
+    Tilemap* tilemap = &renderData->tilemap;
+    IVec2 chunkCoord = {x >> CHUNK_SHIFT, y >> CHUNK_SHIFT};
+    int region = get_tilemap_region(chunkCoord);
+    if(!(tilemap->regionCoords[region] == chunkCoord) || !tilemap->regionLoaded[region]) return;
+    Tile* tile = get_tile(x, y);
+    unsigned char* data = tile ? reserve_tilemap_upload({x, y}, {1, 1}) : nullptr;
+    if(data) *data = get_tilemap_index(*tile);
+    else tilemap->regionLoaded[region] = false;
+}
+
+// Uploads the chunks in [minChunk, maxChunk] that the tilemap does not hold yet, false once the upload queue is full
+bool upload_tilemap_window(Tilemap* tilemap, IVec2 minChunk, IVec2 maxChunk){
+    for(int chunkY = minChunk.y; chunkY <= maxChunk.y; chunkY++){
+        for(int chunkX = minChunk.x; chunkX <= maxChunk.x; chunkX++){
+            IVec2 chunkCoord = {chunkX, chunkY};
+            int region = get_tilemap_region(chunkCoord);
+            Chunk* chunk = get_chunk(chunkWorld, chunkCoord);
+            if(tilemap->regionCoords[region] == chunkCoord && (tilemap->regionLoaded[region] || !chunk)) continue;
+
+            unsigned char* data = reserve_tilemap_upload({chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE}, {CHUNK_SIZE, CHUNK_SIZE});
+            if(!data) return false;
+            for(int idx = 0; idx < CHUNK_TILE_COUNT; idx++) data[idx] = chunk ? get_tilemap_index(chunk->tiles[idx]) : 0;
+            tilemap->regionCoords[region] = chunkCoord;
+            tilemap->regionLoaded[region] = chunk != nullptr;
+        }
     }
-    return tile;
+    return true;
 }
 
-Tile* get_tile(IVec2 worldPos){ return get_tile(worldPos.x / TILESIZE, worldPos.y / TILESIZE);}
+// Uploads the chunks under the game camera that the tilemap does not hold yet, once when they come into view and
+// again when they finish streaming in. Costs the same however many tiles are on screen
+void update_tilemap(){
+    Tilemap* tilemap = &renderData->tilemap;
+    tilemap->sizeInTiles = chunkWorld->sizeInTiles;
+    tilemap->tileSize = TILESIZE;
+    tilemap->palette = renderData->currentPalette;
+    tilemap->atlasPage = 0;                 // the tileset is part of the aseprite atlas
+    for(int idx = 0; idx < gameState->tileCoords.count; idx++) tilemap->atlasOffsets[idx] = gameState->tileCoords.elements[idx];
 
+    TileRange visibleTiles = get_visible_tile_range(renderData->gameCamera, TILESIZE, chunkWorld->sizeInTiles);
+    if(visibleTiles.min.x >= visibleTiles.max.x || visibleTiles.min.y >= visibleTiles.max.y) return;
+    IVec2 minChunk = {visibleTiles.min.x >> CHUNK_SHIFT, visibleTiles.min.y >> CHUNK_SHIFT};
+    IVec2 maxChunk = {(visibleTiles.max.x - 1) >> CHUNK_SHIFT, (visibleTiles.max.y - 1) >> CHUNK_SHIFT};
+    SM_ASSERT(maxChunk.x - minChunk.x < TILEMAP_REGIONS && maxChunk.y - minChunk.y < TILEMAP_REGIONS,
+              "The game camera sees more tiles than the tilemap holds");
+    if(upload_tilemap_window(tilemap, minChunk, maxChunk)) return;
 
+    // The queue ran full, a large camera jump on top of edits no renderer has taken yet. Stopping here would leave
+    // the wrapped regions under the camera showing what they held before, so the pending uploads are dropped, every
+    // region is forgotten and the whole window is written again. That always fits, uploadData holds the whole texture
+    clear_tilemap_uploads();
+    for(int region = 0; region < TILEMAP_REGIONS * TILEMAP_REGIONS; region++){
+        tilemap->regionCoords[region] = {-1, -1};
+        tilemap->regionLoaded[region] = false;
+    }
+    upload_tilemap_window(tilemap, minChunk, maxChunk);
+}
 
-int get_neigbour_mask(int x, int y, Tile* tile, int* neighbourOffsets){
-    int mask = 0;
-    int neighbourCount = 0;
-    int extendedNeighbourCount = 0;
-    int emptyNeighbourSlot = 0;
-    
+// Tiles outside the world count as solid. -1 while a neighbour inside the world is not streamed in, the mask is left
+// as it is then and fixed up once that chunk loads (see resolve_chunk_seams)
+int get_neigbour_mask(int x, int y){
+    int solidBits = 0;
     for(int n = 0; n < 12; n++){
-        Tile* neighbour = get_tile(x+neighbourOffsets[n*2], y + neighbourOffsets[n * 2 + 1]);
-        if(!neighbour || neighbour->isVisible){
-            mask |= BIT(n);
-            if(n < 8) neighbourCount++;
-            else extendedNeighbourCount++;
-        } else if (n < 8) emptyNeighbourSlot = n;
+        int neighbourX = x + NEIGHBOUR_OFFSETS[n * 2], neighbourY = y + NEIGHBOUR_OFFSETS[n * 2 + 1];
+        Tile* neighbour = get_tile(neighbourX, neighbourY);
+        if(!neighbour){
+            if(neighbourX >= 0 && neighbourX < chunkWorld->sizeInTiles.x && neighbourY >= 0 && neighbourY < chunkWorld->sizeInTiles.y) return -1;
+            solidBits |= BIT(n);
+        }
+        else if(neighbour->isVisible) solidBits |= BIT(n);
     }
+    return neigbour_mask_from_solid(solidBits);
+}
 
-    if(neighbourCount == 7 && emptyNeighbourSlot >= 4) mask = 16 + (emptyNeighbourSlot - 4);
-    else if(neighbourCount == 8 && extendedNeighbourCount == 4) mask = 20;
-    else mask &= 0b1111;
-    return mask;
+void update_neigbour_mask(int x, int y){
+    Tile* tile = get_tile(x, y);
+    if(!tile || !tile->isVisible) return;
+    int mask = get_neigbour_mask(x, y);
+    if(mask < 0 || tile->neigbourMask == mask) return;
+    tile->neigbourMask = mask;
+    mark_tile_dirty(chunkWorld, x, y);
+    upload_tilemap_tile(x, y);
+}
+
+// Masks look up to two tiles away, so an edit only changes the masks inside a 5x5 area around it
+void update_neigbour_masks(IVec2 tilePos){
+    for(int y = tilePos.y - 2; y <= tilePos.y + 2; y++){
+        for(int x = tilePos.x - 2; x <= tilePos.x + 2; x++) update_neigbour_mask(x, y);
+    }
+}
+
+// The loader decodes a chunk against the spill files and the level file, a resident neighbour with unsaved edits can
+// differ from both. Once the chunk is in, the 2 tile strips on both sides of every seam with such a neighbour are
+// masked again, that also catches edits next to the seam that were made while the chunk was missing
+void resolve_chunk_seams(){
+    IVec2 loaded[MAX_CHUNK_REQUESTS_PER_FRAME];
+    int loadedCount = collect_loaded_chunks(chunkWorld, loaded, MAX_CHUNK_REQUESTS_PER_FRAME);
+    for(int idx = 0; idx < loadedCount; idx++){
+        for(int dy = -1; dy <= 1; dy++){
+            for(int dx = -1; dx <= 1; dx++){
+                Chunk* neighbour = (dx || dy) ? get_chunk(chunkWorld, {loaded[idx].x + dx, loaded[idx].y + dy}) : nullptr;
+                if(!neighbour || !neighbour->dirty) continue;
+                IVec2 origin = {loaded[idx].x * CHUNK_SIZE, loaded[idx].y * CHUNK_SIZE};
+                int minX = dx < 0 ? origin.x - 2 : dx > 0 ? origin.x + CHUNK_SIZE - 2 : origin.x;
+                int minY = dy < 0 ? origin.y - 2 : dy > 0 ? origin.y + CHUNK_SIZE - 2 : origin.y;
+                int maxX = dx ? minX + 4 : minX + CHUNK_SIZE, maxY = dy ? minY + 4 : minY + CHUNK_SIZE;
+                for(int y = minY; y < maxY; y++){
+                    for(int x = minX; x < maxX; x++) update_neigbour_mask(x, y);
+                }
+            }
+        }
+    }
 }
 
-void set_neigbour_masks(){
-    int neighbourOffsets[24] = {  0,-1,   -1, 0,    1, 0,    0, 1,
-                                 -1,-1,    1,-1,   -1, 1,    1, 1,
-                                  0,-2,   -2, 0,    2, 0,    0, 2};
-    for(int y = 0; y < WORLD_GRID.y; y++){
-        for(int x = 0; x < WORLD_GRID.x; x++){
-            Tile* tile = get_tile(x, y);
-            if(!tile->isVisible)continue;
-            tile->neigbourMask = get_neigbour_mask(x, y, tile, neighbourOffsets);
-            
-            Transform transform ={};
-            transform.pos = {x * (float)TILESIZE, y * (float)TILESIZE};
-            transform.size = {8,8};
-            transform.spriteSize = {8, 8};
-            transform.atlasOffset = gameState->tileCoords[tile->neigbourMask];
-            draw_quad(transform);
+// Everything below only reads and writes the state and input it is handed, so batches of instances can run on any thread
+void init_game_state(GameState* state){
+    state->initialized = true;
+    state->MapKeys(maps, sizeof(maps)/sizeof(maps[0]));
+
+    IVec2 tilesPosition = {48, 0};
+    for(int y = 0; y < 5; y++){
+        for(int x = 0; x < 4; x++){
+            state->tileCoords.add({tilesPosition.x + x * 8, tilesPosition.y + y * 8});
         }
     }
+    state->tileCoords.add({tilesPosition.x, tilesPosition.y+5*8});
+    state->playerAnimation = make_animation_state(ANIMATION_DICE_ROLL);
+}
+
+// One frame of an instance: holding R walks back through its rewind buffer and pauses it, otherwise the player moves
+// and the frame is captured. Returns whether it rewound
+bool step_game(GameState* state, Input* in, RewindBuffer* rewind){
+    if(in->keys[KEY_R].isDown && rewind_step_back(rewind, state)) return true;
+
+    if(is_down(state, in, MOVE_LEFT)) state->playerPos.x -= 1;
+    if(is_down(state, in, MOVE_RIGHT)) state->playerPos.x += 1;
+    if(is_down(state, in, MOVE_UP)) state->playerPos.y -= 1;
+    if(is_down(state, in, MOVE_DOWN)) state->playerPos.y += 1;
+
+    // The dice only rolls while it moves
+    bool moving = is_down(state, in, MOVE_LEFT) || is_down(state, in, MOVE_RIGHT) ||
+                  is_down(state, in, MOVE_UP) || is_down(state, in, MOVE_DOWN);
+    update_animations(&state->playerAnimation, 1, moving ? FRAME_TIME : 0.0f);
+    rewind_capture(rewind, state);
+    return false;
 }
 
 //#####################################################################################################################################
 //                                                  Game Functions(Exposed)
 //#####################################################################################################################################
-EXPORT_FN void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn){
+EXPORT_FN void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn, ParticleSystem* particleSystemIn,
+                           ChunkWorld* chunkWorldIn, RewindBuffer* rewindBufferIn){
     if(renderData != renderDataIn){
         gameState = gameStateIn;
         input = inputIn;
         renderData = renderDataIn;
+        particleSystem = particleSystemIn;
+        chunkWorld = chunkWorldIn;
+        rewindBuffer = rewindBufferIn;
     }
 
     if(!gameState->initialized){
+        init_game_state(gameState);
         renderData->gameCamera.dimensions = {WORLD_WIDTH, WORLD_HEIGHT};
-        gameState->initialized = true;
-
-        gameState->MapKeys(maps, sizeof(maps)/sizeof(maps[0]));
-        
         renderData->gameCamera.position = {160, -90};
+        renderData->gameCamera.snapToPixel = true;
+        // UI coordinates are native pixels from the top left of the screen
+        renderData->uiCamera.dimensions = {WORLD_WIDTH, WORLD_HEIGHT};
+        renderData->uiCamera.position = {WORLD_WIDTH / 2.0f, -WORLD_HEIGHT / 2.0f};
+        renderData->prevGameCameraPos = renderData->gameCamera.position;
         {
-            IVec2 tilesPosition = {48, 0};
-            for(int y = 0; y < 5; y++){
-                for(int x = 0; x < 4; x++){
-                    gameState->tileCoords.add({tilesPosition.x + x * 8, tilesPosition.y + y * 8});
-                }
-            }
-            gameState->tileCoords.add({tilesPosition.x, tilesPosition.y+5*8});
+            ParticleEmitterDesc dust = {};
+            dust.spriteID = SPRITE_WHITE;
+            dust.spawnExtent = {TILESIZE / 2.0f, TILESIZE / 2.0f};
+            dust.velMin = {-40.0f, -80.0f};
+            dust.velMax = {40.0f, -20.0f};
+            dust.gravity = 240.0f;
+            dust.lifetime = 0.5f;
+            gameState->dustEmitter = create_particle_emitter(dust);
         }
     }
 
-    if(is_down(MOUSE_LEFT) || is_down(MOUSE_RIGHT)){
-        if(is_down(MOUSE_LEFT)){
-            Tile* tile = get_tile(input->mousePosWorld);
-            if(tile) tile->isVisible = true;
+    // Chunks finished after this point are only drawn next frame
+    int completedChunkRequests = chunkWorld->completedRequests.load(std::memory_order_acquire);
+    bool cameraMoved = false;
+    {
+        OrthographicCamera2D* camera = &renderData->gameCamera;
+        if(is_down(MOUSE_MIDDLE) && input->screenSize.x > 0 && input->screenSize.y > 0){
+            // Drag the level with the mouse, the view is y flipped relative to camera.position (see get_camera_view)
+            UpscaleViewport viewport = get_upscale_viewport(input->screenSize, get_native_resolution(*camera));
+            camera->position.x -= input->relMouse.x * camera->dimensions.x / viewport.size.x;
+            camera->position.y += input->relMouse.y * camera->dimensions.y / viewport.size.y;
         }
-        if(is_down(MOUSE_RIGHT)){
-            Tile* tile = get_tile(input->mousePosWorld);
-            if(tile) tile->isVisible = false;
-        }
-        set_neigbour_masks();
-    }else{         
-        for(int y = 0; y < WORLD_GRID.y; y++){
-            for(int x = 0; x < WORLD_GRID.x; x++){
-                Tile* tile = get_tile(x, y);
-                if(!tile->isVisible) continue;
-
-                Transform transform ={};
-                transform.pos = {x * (float)TILESIZE, y * (float)TILESIZE};
-                transform.size = {8,8};
-                transform.spriteSize = {8, 8};
-                transform.atlasOffset = gameState->tileCoords[tile->neigbourMask];
-                draw_quad(transform);
+
+        Vec2 cameraVelocity = {(camera->position.x - renderData->prevGameCameraPos.x) / FRAME_TIME / TILESIZE,
+                               -(camera->position.y - renderData->prevGameCameraPos.y) / FRAME_TIME / TILESIZE};
+        cameraMoved = camera->position.x != renderData->prevGameCameraPos.x || camera->position.y != renderData->prevGameCameraPos.y;
+        renderData->prevGameCameraPos = camera->position;
+        update_chunk_streaming(chunkWorld, get_visible_tile_range(*camera, TILESIZE, chunkWorld->sizeInTiles), cameraVelocity);
+    }
+    resolve_chunk_seams();
+
+    if(key_is_down(KEY_CONTROL) && key_pressed_this_frame(KEY_S)) chunkWorld->saveRequested = true;
+
+    // Holding R walks back through the last REWIND_FRAMES frames, the simulation is paused meanwhile
+    bool rewinding = step_game(gameState, input, rewindBuffer);
+
+    if(!rewinding && (is_down(MOUSE_LEFT) || is_down(MOUSE_RIGHT))){
+        IVec2 tilePos = get_tile_pos(input->mousePosWorld);
+        Tile* tile = get_tile(tilePos.x, tilePos.y);
+        bool isVisible = is_down(MOUSE_LEFT);
+        if(tile && tile->isVisible != isVisible){
+            tile->isVisible = isVisible;
+            mark_tile_dirty(chunkWorld, tilePos.x, tilePos.y);
+            upload_tilemap_tile(tilePos.x, tilePos.y);
+            update_neigbour_masks(tilePos);
+            if(isVisible){
+                emit_particles(gameState->dustEmitter, {(tilePos.x + 0.5f) * TILESIZE, (tilePos.y + 0.5f) * TILESIZE}, 12);
             }
         }
     }
-    
-    draw_sprite(SPRITE_DICE, gameState->playerPos);
-    if(is_down(MOVE_LEFT)) gameState->playerPos.x -= 1;
-    if(is_down(MOVE_RIGHT)) gameState->playerPos.x += 1;
-    if(is_down(MOVE_UP)) gameState->playerPos.y -= 1;
-    if(is_down(MOVE_DOWN)) gameState->playerPos.y += 1;
+    // The world is drawn in sepia while rewinding, only the palette row of each instance changes
+    set_palette(rewinding ? PALETTE_REWIND : PALETTE_DEFAULT);
+    update_tilemap();
+
+    update_particles(FRAME_TIME);
+    draw_particles();
+
+    draw_animation(gameState->playerAnimation, gameState->playerPos);
+
+    // Held keys keep moving things without sending new events, the platform side stops calling in while idle
+    renderData->idle = !cameraMoved && !any_key_down() && !particles_active() &&
+                       chunkWorld->queue.tail.load(std::memory_order_relaxed) == completedChunkRequests;
 
+    begin_render_pass(RENDER_PASS_UI);
+    set_palette(PALETTE_DEFAULT);
+    if(rewinding){
+        // Rewind meter along the top edge, shrinks as the buffer runs dry
+        float fill = (float)rewindBuffer->frameCount / rewindBuffer->frameCapacity;
+        draw_quad({WORLD_WIDTH * fill / 2.0f, 2.0f}, {WORLD_WIDTH * fill, 2.0f});
+        char label[32];
+        snprintf(label, sizeof(label), "REWIND %d", rewindBuffer->frameCount);
+        draw_sprite(PACKED_SPRITE_REWIND, Vec2{5.5f, 7.5f});
+        draw_text(label, {11.0f, 5.0f});
+    }
 }
 
+// Steps states[idx] through frameCount frames of step_game. inputs holds streamCount recorded streams of frameCount
+// frames each, instance idx replays stream idx % streamCount. Work is split across every core, each worker keeps one
+// rewind buffer from scratch that every instance it runs starts over in. Nothing is rendered and no global is read or
+// written, uninitialized states are initialized without the render or particle side. Only the frames are timed, the
+// threads are started and waiting before the clock starts
+EXPORT_FN void simulate_game_batch(GameState* states, int count, Input* inputs, int streamCount, int frameCount,
+                                   BumpAllocator* scratch, SimulationReport* report){
+    SM_ASSERT_GUARD(streamCount > 0, , "Batch Simulation needs at least one input stream");
+    int threadCount = (int)std::thread::hardware_concurrency();
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > MAX_SIMULATION_THREADS) threadCount = MAX_SIMULATION_THREADS;
+    if(threadCount > count) threadCount = count > 0 ? count : 1;
+
+    RewindBuffer rewinds[MAX_SIMULATION_THREADS];
+    for(int thread = 0; thread < threadCount; thread++){
+        rewinds[thread] = make_rewind_buffer(scratch, sizeof(GameState), REWIND_FRAMES, REWIND_KEYFRAME_INTERVAL, REWIND_DATA_SIZE);
+    }
+
+    std::atomic<int> readyCount = 0, doneCount = 0;
+    std::atomic<bool> go = false;
+    auto simulate_range = [&](int thread, int first, int last){
+        readyCount.fetch_add(1, std::memory_order_release);
+        while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        for(int idx = first; idx < last; idx++){
+            GameState* state = &states[idx];
+            if(!state->initialized) init_game_state(state);
+            clear_rewind_buffer(&rewinds[thread]);
+            Input* stream = &inputs[(long long)(idx % streamCount) * frameCount];
+            for(int frame = 0; frame < frameCount; frame++) step_game(state, &stream[frame], &rewinds[thread]);
+        }
+        doneCount.fetch_add(1, std::memory_order_release);
+    };
+
+    std::thread threads[MAX_SIMULATION_THREADS];
+    int perThread = (count + threadCount - 1) / threadCount;
+    for(int thread = 0; thread < threadCount; thread++){
+        int first = thread * perThread;
+        int last = first + perThread < count ? first + perThread : count;
+        if(first > last) first = last;
+        threads[thread] = std::thread(simulate_range, thread, first, last);
+    }
+    while(readyCount.load(std::memory_order_acquire) < threadCount) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    while(doneCount.load(std::memory_order_acquire) < threadCount) std::this_thread::yield();
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    for(int thread = 0; thread < threadCount; thread++) threads[thread].join();
+
+    if(!report) return;
+    report->threadCount = threadCount;
+    report->simulatedFrames = (long long)count * frameCount;
+    report->elapsedMs = elapsedMs;
+    report->framesPerSecond = elapsedMs > 0.0 ? report->simulatedFrames / (elapsedMs / 1000.0) : 0.0;
+    report->framesPerSecondPerCore = report->framesPerSecond / threadCount;
+}
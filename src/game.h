@@ -3,6 +3,10 @@
 #include "engine_lib.h"
 #include "input.h"
 #include "render_interface.h"
+#include "particles.h"
+#include "animation.h"
+#include "world.h"
+#include "rewind.h"
 
 
 //#####################################################################################################################################
@@ -13,27 +17,30 @@ constexpr int WORLD_WIDTH = 320;
 constexpr int WORLD_HEIGHT = 180;
 constexpr int TILESIZE = 8;
 constexpr IVec2 WORLD_GRID = {WORLD_WIDTH /TILESIZE, WORLD_HEIGHT / TILESIZE};
+constexpr IVec2 LEVEL_SIZE = {100000, 100000};
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+constexpr int MAX_SIMULATION_THREADS = 64;
+constexpr int REWIND_FRAMES = 10 * 60;
+constexpr int REWIND_KEYFRAME_INTERVAL = 60;
+constexpr int REWIND_DATA_SIZE = KB(256);                  // holds REWIND_FRAMES even if every frame were a keyframe
 //#####################################################################################################################################
 //                                                  Game Structs
 //#####################################################################################################################################
 enum GameInputType{
     MOVE_LEFT, MOVE_RIGHT, MOVE_UP, MOVE_DOWN,
     JUMP,
-    MOUSE_LEFT, MOUSE_RIGHT,
+    MOUSE_LEFT, MOUSE_RIGHT, MOUSE_MIDDLE,
     GAME_INPUT_COUNT 
 };
 struct KeyMap { GameInputType type; KeyCodeID code; };
 struct KeyMapping{ Array<KeyCodeID, 3> keys; };
-struct Tile{
-    int neigbourMask;
-    bool isVisible;
-};
 struct GameState{
     bool initialized = false;
     IVec2 playerPos;
+    AnimationState playerAnimation;
+    int dustEmitter;
     
-    Array<IVec2, 21> tileCoords;
-    Tile worldGrid[WORLD_GRID.x][WORLD_GRID.y];
+    Array<IVec2, MAX_TILEMAP_TILES> tileCoords;
     
     KeyMapping keyMappings[GAME_INPUT_COUNT];
     void MapKeys(KeyMap *keymaps, int size){  
@@ -44,6 +51,14 @@ struct GameState{
     }
 };
 
+struct SimulationReport{
+    int threadCount;
+    long long simulatedFrames;
+    double elapsedMs;
+    double framesPerSecond;
+    double framesPerSecondPerCore;
+};
+
 //#####################################################################################################################################
 //                                                  Game Globals
 //#####################################################################################################################################
@@ -52,5 +67,8 @@ static GameState* gameState;
 //                                                  Game Functions (Exposed)  
 //#####################################################################################################################################
 extern "C" {
-    EXPORT_FN void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn);
+    EXPORT_FN void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn, ParticleSystem* particleSystemIn,
+                                ChunkWorld* chunkWorldIn, RewindBuffer* rewindBufferIn);
+    EXPORT_FN void simulate_game_batch(GameState* states, int count, Input* inputs, int streamCount, int frameCount,
+                                       BumpAllocator* scratch, SimulationReport* report);
 }
\ No newline at end of file
@@ -7,22 +7,120 @@
 #include <stb_image.h>
 
 #include "render_interface.h"
+#include "palette.h"
+#include "render_metrics.h"
+#include "frame_capture.h"
+
+#include <atomic>
+#include <thread>
 
 //#####################################################################################################################################
 //                                                  OpenGl Constants
 //#####################################################################################################################################
 
-const char* TEXTURE_PATH = "assets/textures/Texture_Atlas.png";
+// Every pass gets its own slot in the uniform buffer, 256 is the largest offset alignment GL allows
+constexpr int GL_PASS_UNIFORM_STRIDE = 256;
+constexpr int GL_INITIAL_TRANSFORM_CAPACITY = 1 << 14;  // the instance buffer doubles from here up to MAX_TRANSFORMS
+constexpr int GL_ATLAS_TILE_SIZE = 32;                  // an atlas reload uploads the tiles of this size that changed
+constexpr size_t GL_ATLAS_STORAGE_SIZE = MB(16);        // per version of the atlas, two are kept
+constexpr int GL_CAPTURE_BUFFER_COUNT = 3;              // frames a capture readback may lag behind before it waits
+constexpr long long GL_CAPTURE_FENCE_TIMEOUT_NS = 100000000;
 
 //#####################################################################################################################################
 //                                                  OpenGl Strucs
 //#####################################################################################################################################
 
+// std140 layout of RenderPassUBO in quad.vert
+struct GLPassUniforms{
+    Mat4 orthoProjection;
+    Vec2 screenSize;
+    int instanceOffset;
+    int padding;
+};
+
+// std140, matches TilemapUBO in tilemap.frag
+struct GLTilemapUniforms{
+    Vec2 viewMin;
+    Vec2 viewSize;
+    Vec2 screenSize;
+    IVec2 sizeInTiles;
+    int tileSize;
+    int paletteIdx;
+    int atlasPage;
+    int padding;
+    int atlasOffsets[MAX_TILEMAP_TILES][4];
+};
+
 struct GLContext{
-    GLuint programID, textureID;
-    GLuint transformSBOID, screenSizeID, orthoProjectionID;
+    GLuint programID, textureID, paletteTextureID;
+    GLuint transformSBOID, passUBOID;
+    int transformCapacity;      // Transforms the instance buffer has storage for
+    GLuint tilemapProgramID, tilemapTextureID, tilemapUBOID;
+    IVec2 atlasSize;            // of every layer, the storage is immutable so a different size needs a new texture
+    int atlasPageCount;
+
+    // Offscreen target at the camera's native resolution, upscaled to the window every frame
+    GLuint renderTargetFBOID, renderTargetTextureID, renderTargetDepthID;
+    IVec2 renderTargetSize;
+
+    long long textureTimeStamp, shaderTimeStamp, tilemapShaderTimeStamp;
+};
+
+enum GLAtlasLoadState{
+    GL_ATLAS_LOAD_IDLE,
+    GL_ATLAS_LOAD_RUNNING,      // the worker owns next, the tiles and the mapped upload buffer
+    GL_ATLAS_LOAD_DONE,
+};
 
-    long long textureTimeStamp, shaderTimeStamp;
+// Texels of a changed tile, packed row after row at dataOffset in the upload buffer
+struct GLAtlasTile{
+    int x, y, page;
+    int width, height;
+    int dataOffset;
+};
+
+// Reloads are decoded by a worker thread and diffed against the atlas the GPU has, the changed tiles are written
+// straight into a mapped pixel unpack buffer. The two storages take turns holding the current atlas
+struct GLAtlasLoader{
+    std::thread worker;
+    std::atomic<int> state;
+    BumpAllocator storage[2];
+    int currentStorage;
+    IndexedAtlas* current;
+    IndexedAtlas* next;
+
+    bool fullUpload;            // no tiles, the whole atlas is in the upload buffer or did not fit into it
+    GLAtlasTile* tiles;
+    int tileCount;
+
+    GLuint uploadBufferID;
+    unsigned char* uploadData;
+    int uploadCapacity, uploadSize;
+};
+
+struct GLCaptureBuffer{
+    GLuint bufferID;
+    int bufferSize;
+    GLsync fence;
+    IVec2 size;
+};
+
+// Readbacks of the last few frames into pixel pack buffers, oldest first. Each one is copied into the capture
+// queue once its fence signals, so glReadPixels never waits on the frame it reads
+struct GLCapture{
+    GLCaptureBuffer buffers[GL_CAPTURE_BUFFER_COUNT];
+    int first, count;
+    bool windowResolution;      // the upscaled back buffer instead of the native render target
+};
+
+// Everything gl_init needs from disk, loaded without a GL context so it can happen while the window is created
+struct GLStartupAssets{
+    IndexedAtlas* atlas;
+    char* vertSource;
+    char* fragSource;
+    char* tilemapVertSource;
+    char* tilemapFragSource;
+    long long textureTimeStamp, shaderTimeStamp, tilemapShaderTimeStamp;
 };
 
 //#####################################################################################################################################
@@ -30,6 +128,8 @@ struct GLContext{
 //#####################################################################################################################################
 
 static GLContext glContext;
+static GLAtlasLoader glAtlasLoader;
+static GLCapture glCapture;
 
 //#####################################################################################################################################
 //                                                  OpenGl Functions
@@ -42,10 +142,7 @@ static void APIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id, GL
     }else SM_TRACE((char*) message);
 }
 
-GLuint gl_create_shader(int type, char* path, BumpAllocator* transientStorage){
-    int fileSize = 0;
-    char* shader = read_file(path, &fileSize, transientStorage);
-    SM_ASSERT_GUARD(shader, 0, "Failed to load shader: %s", path);
+GLuint gl_compile_shader(int type, char* shader, char* path){
     GLuint shaderID = glCreateShader(type);
     glShaderSource(shaderID, 1, &shader, 0);
     glCompileShader(shaderID);
@@ -59,59 +156,457 @@ GLuint gl_create_shader(int type, char* path, BumpAllocator* transientStorage){
     return 0;
 }
 
-bool gl_init(BumpAllocator* transientStorage){
+GLuint gl_create_shader(int type, char* path, BumpAllocator* transientStorage){
+    int fileSize = 0;
+    char* shader = read_file(path, &fileSize, transientStorage);
+    SM_ASSERT_GUARD(shader, 0, "Failed to load shader: %s", path);
+    return gl_compile_shader(type, shader, path);
+}
+
+// Links into programID, the shaders are only needed until then
+void gl_link_program(GLuint programID, GLuint vertShaderID, GLuint fragShaderID){
+    glAttachShader(programID, vertShaderID);
+    glAttachShader(programID, fragShaderID);
+    glLinkProgram(programID);
+    glDetachShader(programID, vertShaderID);
+    glDetachShader(programID, fragShaderID);
+    glDeleteShader(vertShaderID);
+    glDeleteShader(fragShaderID);
+}
+
+void gl_reload_program(GLuint programID, char* vertPath, char* fragPath, long long* timeStamp, BumpAllocator* transientStorage){
+    long long timestampVert = get_timestamp(vertPath);
+    long long timestampFrag = get_timestamp(fragPath);
+    if(timestampVert <= *timeStamp && timestampFrag <= *timeStamp) return;
+    GLuint vertShaderID = gl_create_shader(GL_VERTEX_SHADER, vertPath, transientStorage);
+    GLuint fragShaderID = gl_create_shader(GL_FRAGMENT_SHADER, fragPath, transientStorage);
+    SM_ASSERT_GUARD(fragShaderID && vertShaderID, , "Failed to create shaders");
+    gl_link_program(programID, vertShaderID, fragShaderID);
+    *timeStamp = max(timestampFrag, timestampVert);
+    renderMetrics.current.shaderReloads++;
+}
+
+bool gl_create_render_target(IVec2 size){
+    if(glContext.renderTargetFBOID){
+        glDeleteFramebuffers(1, &glContext.renderTargetFBOID);
+        glDeleteTextures(1, &glContext.renderTargetTextureID);
+        glDeleteRenderbuffers(1, &glContext.renderTargetDepthID);
+    }
+    glContext.renderTargetSize = size;
+
+    // Texture units 0 and 1 stay reserved for the atlas and its palettes
+    glActiveTexture(GL_TEXTURE2);
+    glGenTextures(1, &glContext.renderTargetTextureID);
+    glBindTexture(GL_TEXTURE_2D, glContext.renderTargetTextureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glActiveTexture(GL_TEXTURE0);
+
+    glGenRenderbuffers(1, &glContext.renderTargetDepthID);
+    glBindRenderbuffer(GL_RENDERBUFFER, glContext.renderTargetDepthID);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+
+    glGenFramebuffers(1, &glContext.renderTargetFBOID);
+    glBindFramebuffer(GL_FRAMEBUFFER, glContext.renderTargetFBOID);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, glContext.renderTargetTextureID, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, glContext.renderTargetDepthID);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    SM_ASSERT_GUARD(status == GL_FRAMEBUFFER_COMPLETE, false, "Render target %dx%d is incomplete: 0x%x", size.x, size.y, status);
+    return true;
+}
+
+// Every atlas page goes up as one layer of an R8UI array texture, one color index per texel, and their shared colors
+// as one row per PaletteID in the palette texture. Sprites pick their layer per instance, so pages never split a draw
+// Immutable storage, a different layer size or page count gets a new texture
+void gl_create_atlas_texture(IVec2 size, int pageCount){
+    if(glContext.textureID) glDeleteTextures(1, &glContext.textureID);
+    // Integer textures are only complete with nearest filtering
+    glGenTextures(1, &glContext.textureID);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, glContext.textureID);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8UI, size.x, size.y, pageCount);
+    glContext.atlasSize = size;
+    glContext.atlasPageCount = pageCount;
+}
+
+void gl_upload_palettes(IndexedAtlas* atlas){
+    glActiveTexture(GL_TEXTURE1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MAX_PALETTE_COLORS, PALETTE_COUNT, GL_RGBA, GL_UNSIGNED_BYTE, atlas->palettes);
+    glActiveTexture(GL_TEXTURE0);
+    renderMetrics.current.uploadBytes += sizeof(atlas->palettes);
+}
+
+// All of it straight from client memory
+void gl_upload_atlas(IndexedAtlas* atlas){
+    IVec2 size = {atlas->width, atlas->height};
+    if(!(size == glContext.atlasSize) || atlas->pageCount != glContext.atlasPageCount){
+        gl_create_atlas_texture(size, atlas->pageCount);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glActiveTexture(GL_TEXTURE0);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, atlas->width, atlas->height, atlas->pageCount,
+                    GL_RED_INTEGER, GL_UNSIGNED_BYTE, atlas->indices);
+    gl_upload_palettes(atlas);
+    renderMetrics.current.textureReloads++;
+    renderMetrics.current.uploadBytes += (long long)atlas->width * atlas->height * atlas->pageCount;
+    SM_TRACE("Atlas of %d %dx%d pages uses %d colors", atlas->pageCount, atlas->width, atlas->height, atlas->colorCount);
+}
+
+// Worker thread, no GL calls. Only reads current, which the main thread leaves alone until the state is DONE
+void gl_run_atlas_loader(GLAtlasLoader* loader){
+    BumpAllocator* storage = &loader->storage[1 - loader->currentStorage];
+    storage->used = 0;
+    IndexedAtlas* current = loader->current;
+    IndexedAtlas* next = load_indexed_atlas(storage);
+    loader->next = next;
+    loader->tileCount = 0;
+    loader->uploadSize = 0;
+
+    if(next){
+        int layerSize = next->width * next->height;
+        int atlasSize = layerSize * next->pageCount;
+        loader->fullUpload = !loader->uploadData || next->width != current->width ||
+                             next->height != current->height || next->pageCount != current->pageCount;
+        if(loader->fullUpload){
+            if(loader->uploadData && atlasSize <= loader->uploadCapacity){
+                memcpy(loader->uploadData, next->indices, atlasSize);
+                loader->uploadSize = atlasSize;
+            }
+        } else {
+            int tilesX = (next->width + GL_ATLAS_TILE_SIZE - 1) / GL_ATLAS_TILE_SIZE;
+            int tilesY = (next->height + GL_ATLAS_TILE_SIZE - 1) / GL_ATLAS_TILE_SIZE;
+            loader->tiles = (GLAtlasTile*)bump_alloc(storage, sizeof(GLAtlasTile) * tilesX * tilesY * next->pageCount);
+            for(int page = 0; page < next->pageCount; page++){
+                for(int tileY = 0; tileY < tilesY; tileY++){
+                    for(int tileX = 0; tileX < tilesX; tileX++){
+                        GLAtlasTile tile = {};
+                        tile.x = tileX * GL_ATLAS_TILE_SIZE;
+                        tile.y = tileY * GL_ATLAS_TILE_SIZE;
+                        tile.page = page;
+                        tile.width = min(GL_ATLAS_TILE_SIZE, next->width - tile.x);
+                        tile.height = min(GL_ATLAS_TILE_SIZE, next->height - tile.y);
+                        tile.dataOffset = loader->uploadSize;
+
+                        int offset = page * layerSize + tile.y * next->width + tile.x;
+                        unsigned char* src = next->indices + offset;
+                        unsigned char* old = current->indices + offset;
+                        bool changed = false;
+                        for(int row = 0; row < tile.height && !changed; row++){
+                            changed = memcmp(src + row * next->width, old + row * next->width, tile.width) != 0;
+                        }
+                        if(!changed) continue;
+
+                        for(int row = 0; row < tile.height; row++){
+                            memcpy(loader->uploadData + loader->uploadSize, src + row * next->width, tile.width);
+                            loader->uploadSize += tile.width;
+                        }
+                        loader->tiles[loader->tileCount++] = tile;
+                    }
+                }
+            }
+        }
+    }
+    loader->state.store(GL_ATLAS_LOAD_DONE, std::memory_order_release);
+}
+
+// Orphans the upload buffer and hands a mapping of it to the worker, it is sized for the current atlas which holds
+// every diff. Only a resized atlas can need more and falls back to client memory. Only one reload is ever in flight,
+// a texture upload still reading the last storage keeps it until it is done
+void gl_begin_atlas_reload(){
+    GLAtlasLoader* loader = &glAtlasLoader;
+    IndexedAtlas* current = loader->current;
+    loader->uploadCapacity = current->width * current->height * current->pageCount;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader->uploadBufferID);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, loader->uploadCapacity, nullptr, GL_STREAM_DRAW);
+    loader->uploadData = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, loader->uploadCapacity,
+                                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(!loader->uploadData) SM_WARN("Failed to map the Atlas upload buffer, uploading from client memory");
+
+    loader->state.store(GL_ATLAS_LOAD_RUNNING, std::memory_order_relaxed);
+    loader->worker = std::thread(gl_run_atlas_loader, loader);
+}
+
+void gl_finish_atlas_reload(){
+    GLAtlasLoader* loader = &glAtlasLoader;
+    loader->worker.join();
+    loader->state.store(GL_ATLAS_LOAD_IDLE, std::memory_order_relaxed);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader->uploadBufferID);
+    if(loader->uploadData) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    loader->uploadData = nullptr;
+
+    IndexedAtlas* next = loader->next;
+    if(!next){
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        SM_ERROR("Failed to reload the atlas, keeping the old one");
+        return;
+    }
+
+    // Offsets into the bound unpack buffer instead of pointers
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glActiveTexture(GL_TEXTURE0);
+    if(loader->fullUpload && loader->uploadSize){
+        IVec2 size = {next->width, next->height};
+        if(!(size == glContext.atlasSize) || next->pageCount != glContext.atlasPageCount){
+            gl_create_atlas_texture(size, next->pageCount);
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, next->width, next->height, next->pageCount,
+                        GL_RED_INTEGER, GL_UNSIGNED_BYTE, (void*)0);
+    }
+    for(int idx = 0; idx < loader->tileCount; idx++){
+        GLAtlasTile* tile = &loader->tiles[idx];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, tile->x, tile->y, tile->page, tile->width, tile->height, 1,
+                        GL_RED_INTEGER, GL_UNSIGNED_BYTE, (void*)(size_t)tile->dataOffset);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(loader->fullUpload && !loader->uploadSize){
+        gl_upload_atlas(next);
+    } else {
+        gl_upload_palettes(next);
+        renderMetrics.current.textureReloads++;
+        renderMetrics.current.uploadBytes += loader->uploadSize;
+        if(loader->fullUpload){
+            SM_TRACE("Atlas of %d %dx%d pages uses %d colors", next->pageCount, next->width, next->height, next->colorCount);
+        } else {
+            int tilesX = (next->width + GL_ATLAS_TILE_SIZE - 1) / GL_ATLAS_TILE_SIZE;
+            int tilesY = (next->height + GL_ATLAS_TILE_SIZE - 1) / GL_ATLAS_TILE_SIZE;
+            SM_TRACE("Atlas reloaded, %d of %d tiles changed (%d KB)",
+                     loader->tileCount, tilesX * tilesY * next->pageCount, loader->uploadSize / 1024);
+        }
+    }
+
+    loader->current = next;
+    loader->currentStorage = 1 - loader->currentStorage;
+}
+
+// Applies the tile uploads of the frame and fills in the uniforms, false when there is no tile layer to draw
+bool gl_upload_tilemap(IVec2 nativeSize){
+    Tilemap* tilemap = &renderData->tilemap;
+    if(tilemap->uploads.count){
+        glActiveTexture(GL_TEXTURE3);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(int idx = 0; idx < tilemap->uploads.count; idx++){
+            TilemapUpload upload = tilemap->uploads.elements[idx];
+            glTexSubImage2D(GL_TEXTURE_2D, 0, upload.pos.x & (TILEMAP_SIZE - 1), upload.pos.y & (TILEMAP_SIZE - 1),
+                            upload.size.x, upload.size.y, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tilemap->uploadData + upload.dataOffset);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        renderMetrics.current.uploadBytes += tilemap->uploadDataSize;
+        clear_tilemap_uploads();
+    }
+    if(tilemap->sizeInTiles.x <= 0 || tilemap->sizeInTiles.y <= 0 || tilemap->tileSize <= 0) return false;
+
+    ViewRect view = get_camera_view(renderData->gameCamera);
+    GLTilemapUniforms uniforms = {};
+    uniforms.viewMin = view.min;
+    uniforms.viewSize = view.max - view.min;
+    uniforms.screenSize = vec_2(nativeSize);
+    uniforms.sizeInTiles = tilemap->sizeInTiles;
+    uniforms.tileSize = tilemap->tileSize;
+    uniforms.paletteIdx = tilemap->palette;
+    uniforms.atlasPage = tilemap->atlasPage;
+    for(int idx = 0; idx < MAX_TILEMAP_TILES; idx++){
+        uniforms.atlasOffsets[idx][0] = tilemap->atlasOffsets[idx].x;
+        uniforms.atlasOffsets[idx][1] = tilemap->atlasOffsets[idx].y;
+    }
+    // The pass uniforms are written through the generic binding as well
+    glBindBuffer(GL_UNIFORM_BUFFER, glContext.tilemapUBOID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniforms), &uniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, glContext.passUBOID);
+    renderMetrics.current.uploadBytes += sizeof(uniforms);
+    return true;
+}
+
+// Hands finished readbacks to the capture queue, only waits on the GPU while the ring is full or when flushing
+void gl_collect_captures(bool flush){
+    while(glCapture.count){
+        GLCaptureBuffer* buffer = &glCapture.buffers[glCapture.first];
+        bool mustWait = flush || glCapture.count == GL_CAPTURE_BUFFER_COUNT;
+        GLenum result = glClientWaitSync(buffer->fence, GL_SYNC_FLUSH_COMMANDS_BIT, mustWait ? GL_CAPTURE_FENCE_TIMEOUT_NS : 0);
+        if(result == GL_TIMEOUT_EXPIRED && !mustWait) break;
+        glDeleteSync(buffer->fence);
+        glCapture.first = (glCapture.first + 1) % GL_CAPTURE_BUFFER_COUNT;
+        glCapture.count--;
+
+        if(result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED){
+            SM_ERROR("Failed to wait on a Frame Capture readback");
+            frameCapture.droppedFrames++;
+            continue;
+        }
+        unsigned int* pixels = begin_capture_frame(buffer->size);
+        if(!pixels) continue;
+
+        // GL counts rows from the bottom
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->bufferID);
+        unsigned int* data = (unsigned int*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, buffer->bufferSize, GL_MAP_READ_BIT);
+        if(data){
+            for(int row = 0; row < buffer->size.y; row++){
+                memcpy(pixels + row * buffer->size.x, data + (buffer->size.y - 1 - row) * buffer->size.x, sizeof(unsigned int) * buffer->size.x);
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            submit_capture_frame();
+        } else {
+            SM_ERROR("Failed to map a Frame Capture readback");
+            frameCapture.droppedFrames++;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+// Between gl_render and platform_swap_buffers, while the back buffer still holds the frame
+void gl_capture_frame(){
+    if(!frameCapture.running) return;
+    gl_collect_captures(false);
+
+    IVec2 size = glCapture.windowResolution ? input->screenSize : glContext.renderTargetSize;
+    GLCaptureBuffer* buffer = &glCapture.buffers[(glCapture.first + glCapture.count) % GL_CAPTURE_BUFFER_COUNT];
+    if(!buffer->bufferID) glGenBuffers(1, &buffer->bufferID);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer->bufferID);
+    int bufferSize = (int)sizeof(unsigned int) * size.x * size.y;
+    if(bufferSize != buffer->bufferSize){
+        glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+        buffer->bufferSize = bufferSize;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, glCapture.windowResolution ? 0 : glContext.renderTargetFBOID);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    buffer->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    buffer->size = size;
+    glCapture.count++;
+}
+
+// *.y4m records a video, anything else a directory of PPMs, see start_frame_capture. The game never waits for
+// the writer, frames it can not keep up with are dropped
+bool gl_start_capture(char* path, bool windowResolution){
+    glCapture.windowResolution = windowResolution;
+    IVec2 size = windowResolution ? input->screenSize : get_native_resolution(renderData->gameCamera);
+    return start_frame_capture(path, size, true);
+}
+
+void gl_stop_capture(){
+    gl_collect_captures(true);
+    stop_frame_capture();
+}
+
+// The worker only runs for a moment, but a std::thread still joinable at exit terminates the process
+void gl_shutdown(){
+    if(glAtlasLoader.worker.joinable()) glAtlasLoader.worker.join();
+    gl_stop_capture();
+}
+
+// No GL calls, safe on any thread. Timestamps are taken first so an edit made meanwhile is still hot reloaded
+bool gl_load_startup_assets(GLStartupAssets* assets, BumpAllocator* storage){
+    assets->textureTimeStamp = get_atlas_timestamp();
+    assets->shaderTimeStamp = max(get_timestamp("assets/shaders/quad.vert"), get_timestamp("assets/shaders/quad.frag"));
+    assets->tilemapShaderTimeStamp = max(get_timestamp("assets/shaders/tilemap.vert"), get_timestamp("assets/shaders/tilemap.frag"));
+    int fileSize = 0;
+    assets->vertSource = read_file("assets/shaders/quad.vert", &fileSize, storage);
+    assets->fragSource = read_file("assets/shaders/quad.frag", &fileSize, storage);
+    assets->tilemapVertSource = read_file("assets/shaders/tilemap.vert", &fileSize, storage);
+    assets->tilemapFragSource = read_file("assets/shaders/tilemap.frag", &fileSize, storage);
+    assets->atlas = load_indexed_atlas(storage);
+    SM_ASSERT_GUARD(assets->vertSource && assets->fragSource && assets->tilemapVertSource && assets->tilemapFragSource,
+                    false, "Failed to load shaders");
+    SM_ASSERT_GUARD(assets->atlas, false, "Failed to load the atlas");
+    return true;
+}
+
+// Only GL calls are left here, the files were read by gl_load_startup_assets
+bool gl_init(GLStartupAssets* assets){
     gl_load_functions();
     glDebugMessageCallback(&gl_debug_callback, nullptr);
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
     glEnable(GL_DEBUG_OUTPUT);
 
-    GLuint vertShaderID = gl_create_shader(GL_VERTEX_SHADER, "assets/shaders/quad.vert", transientStorage);
-    GLuint fragShaderID = gl_create_shader(GL_FRAGMENT_SHADER, "assets/shaders/quad.frag", transientStorage);
+    SM_ASSERT_GUARD(assets->vertSource && assets->fragSource && assets->tilemapVertSource && assets->tilemapFragSource &&
+                    assets->atlas, false, "Startup assets are missing");
+    GLuint vertShaderID = gl_compile_shader(GL_VERTEX_SHADER, assets->vertSource, "assets/shaders/quad.vert");
+    GLuint fragShaderID = gl_compile_shader(GL_FRAGMENT_SHADER, assets->fragSource, "assets/shaders/quad.frag");
     SM_ASSERT_GUARD(fragShaderID && vertShaderID, false, "Failed to create shaders");
-    long long timestampVert = get_timestamp("assets/shaders/quad.vert");
-    long long timestampFrag = get_timestamp("assets/shaders/quad.frag");
-    glContext.shaderTimeStamp = max(timestampFrag, timestampVert);
-
     glContext.programID = glCreateProgram();
-    glAttachShader(glContext.programID, vertShaderID);
-    glAttachShader(glContext.programID, fragShaderID);
-    glLinkProgram(glContext.programID);
-    glDetachShader(glContext.programID, vertShaderID);
-    glDetachShader(glContext.programID, fragShaderID);
-    glDeleteShader(vertShaderID);
-    glDeleteShader(fragShaderID);
+    gl_link_program(glContext.programID, vertShaderID, fragShaderID);
+    glContext.shaderTimeStamp = assets->shaderTimeStamp;
+
+    vertShaderID = gl_compile_shader(GL_VERTEX_SHADER, assets->tilemapVertSource, "assets/shaders/tilemap.vert");
+    fragShaderID = gl_compile_shader(GL_FRAGMENT_SHADER, assets->tilemapFragSource, "assets/shaders/tilemap.frag");
+    SM_ASSERT_GUARD(fragShaderID && vertShaderID, false, "Failed to create shaders");
+    glContext.tilemapProgramID = glCreateProgram();
+    gl_link_program(glContext.tilemapProgramID, vertShaderID, fragShaderID);
+    glContext.tilemapShaderTimeStamp = assets->tilemapShaderTimeStamp;
 
     GLuint VAO;
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
 
     {
-        int width, height, channels;
-        char* data = (char*)stbi_load(TEXTURE_PATH, &width, &height, &channels, 4);
-        SM_ASSERT_GUARD(data, false, "Failed to load texture");
-        glGenTextures(1, &glContext.textureID);
+        glGenTextures(1, &glContext.paletteTextureID);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, glContext.paletteTextureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_SRGB8_ALPHA8, MAX_PALETTE_COLORS, PALETTE_COUNT);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, glContext.textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-        glContext.textureID = get_timestamp(TEXTURE_PATH);
-
-        stbi_image_free(data);
+        // Reloads are diffed against this copy, the startup storage is freed once gl_init returns
+        GLAtlasLoader* loader = &glAtlasLoader;
+        loader->storage[0] = make_bump_allocator(GL_ATLAS_STORAGE_SIZE);
+        loader->storage[1] = make_bump_allocator(GL_ATLAS_STORAGE_SIZE);
+        IndexedAtlas* atlas = (IndexedAtlas*)bump_alloc(&loader->storage[0], sizeof(IndexedAtlas));
+        *atlas = *assets->atlas;
+        size_t atlasSize = (size_t)atlas->width * atlas->height * atlas->pageCount;
+        atlas->indices = (unsigned char*)bump_alloc(&loader->storage[0], atlasSize);
+        memcpy(atlas->indices, assets->atlas->indices, atlasSize);
+        loader->current = atlas;
+        glGenBuffers(1, &loader->uploadBufferID);
+
+        gl_upload_atlas(atlas);
+        glContext.textureTimeStamp = assets->textureTimeStamp;
     }
 
     {
         glGenBuffers(1, &glContext.transformSBOID);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, glContext.transformSBOID);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Transform) * renderData->transforms.maxElements, renderData->transforms.elements, GL_DYNAMIC_DRAW);
+        glContext.transformCapacity = GL_INITIAL_TRANSFORM_CAPACITY;
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Transform) * glContext.transformCapacity, nullptr, GL_DYNAMIC_DRAW);
     }
 
     {
-        glContext.screenSizeID = glGetUniformLocation(glContext.programID, "screenSize");
-        glContext.orthoProjectionID = glGetUniformLocation(glContext.programID, "orthoProjection");
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        SM_ASSERT_GUARD(alignment > 0 && GL_PASS_UNIFORM_STRIDE % alignment == 0, false, "Unsupported uniform buffer alignment %d", alignment);
+        glGenBuffers(1, &glContext.passUBOID);
+        glBindBuffer(GL_UNIFORM_BUFFER, glContext.passUBOID);
+        glBufferData(GL_UNIFORM_BUFFER, GL_PASS_UNIFORM_STRIDE * RENDER_PASS_COUNT, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    {
+        // Texture unit 3, the storage starts out undefined so every tile is cleared to empty first
+        glGenTextures(1, &glContext.tilemapTextureID);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, glContext.tilemapTextureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8UI, TILEMAP_SIZE, TILEMAP_SIZE);
+        unsigned char* emptyTiles = (unsigned char*)calloc(1, TILEMAP_SIZE * TILEMAP_SIZE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, TILEMAP_SIZE, TILEMAP_SIZE, GL_RED_INTEGER, GL_UNSIGNED_BYTE, emptyTiles);
+        free(emptyTiles);
+        glActiveTexture(GL_TEXTURE0);
+
+        glGenBuffers(1, &glContext.tilemapUBOID);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 1, glContext.tilemapUBOID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(GLTilemapUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, glContext.passUBOID);
     }
 
     glEnable(GL_BLEND);
@@ -123,63 +618,93 @@ bool gl_init(BumpAllocator* transientStorage){
 
     glUseProgram(glContext.programID);
 
+    SM_ASSERT_GUARD(gl_create_render_target(get_native_resolution(renderData->gameCamera)), false, "Failed to create the render target");
+
     return true;
 }
 
 void gl_render(BumpAllocator* transientStorage){
 
     {
-        long long currentTimestamp = get_timestamp(TEXTURE_PATH);
-        if(currentTimestamp > glContext.textureTimeStamp){
-            glActiveTexture(GL_TEXTURE0);
-            int width, height, nChannels;
-            char* data = (char*)stbi_load(TEXTURE_PATH, &width, &height, &nChannels, 4);
-            if(data){
-                glContext.textureTimeStamp = currentTimestamp;
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-                stbi_image_free(data);
-            }
+        // Decoded and diffed on the worker, the old atlas stays on screen until the changes are uploaded
+        long long currentTimestamp = get_atlas_timestamp();
+        int loadState = glAtlasLoader.state.load(std::memory_order_acquire);
+        if(loadState == GL_ATLAS_LOAD_DONE) gl_finish_atlas_reload();
+        else if(loadState == GL_ATLAS_LOAD_IDLE && currentTimestamp > glContext.textureTimeStamp){
+            glContext.textureTimeStamp = currentTimestamp;
+            gl_begin_atlas_reload();
         }
     }
 
-    {
-        long long timestampVert = get_timestamp("assets/shaders/quad.vert");
-        long long timestampFrag = get_timestamp("assets/shaders/quad.frag");
-        if(timestampVert > glContext.shaderTimeStamp || timestampFrag > glContext.shaderTimeStamp){
-            GLuint vertShaderID = gl_create_shader(GL_VERTEX_SHADER, "assets/shaders/quad.vert", transientStorage);
-            GLuint fragShaderID = gl_create_shader(GL_FRAGMENT_SHADER, "assets/shaders/quad.frag", transientStorage);
-            SM_ASSERT_GUARD(fragShaderID && vertShaderID, , "Failed to create shaders");
-            glAttachShader(glContext.programID, vertShaderID);
-            glAttachShader(glContext.programID, fragShaderID);
-            glLinkProgram(glContext.programID);
-            glDetachShader(glContext.programID, vertShaderID);
-            glDetachShader(glContext.programID, fragShaderID);
-            glDeleteShader(vertShaderID);
-            glDeleteShader(fragShaderID);
-            glContext.shaderTimeStamp = max(timestampFrag, timestampVert);
-        }
-    }    
+    gl_reload_program(glContext.programID, "assets/shaders/quad.vert", "assets/shaders/quad.frag",
+                      &glContext.shaderTimeStamp, transientStorage);
+    gl_reload_program(glContext.tilemapProgramID, "assets/shaders/tilemap.vert", "assets/shaders/tilemap.frag",
+                      &glContext.tilemapShaderTimeStamp, transientStorage);
+
+    IVec2 nativeSize = get_native_resolution(renderData->gameCamera);
+    if(!(nativeSize == glContext.renderTargetSize)){
+        SM_ASSERT_GUARD(gl_create_render_target(nativeSize), , "Failed to resize the render target");
+    }
 
+    glBindFramebuffer(GL_FRAMEBUFFER, glContext.renderTargetFBOID);
     glClearColor(119.0f/255.0f, 33.0f/255.0f, 111.0f/255.0f, 1.0f);
     glClearDepth(0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glViewport(0, 0, input->screenSize.x, input->screenSize.y);
+    glViewport(0, 0, nativeSize.x, nativeSize.y);
     
-    Vec2 screenSize = vec_2(input->screenSize);
-    glUniform2fv(glContext.screenSizeID, 1, &screenSize.x);
-    OrthographicCamera2D camera = renderData->gameCamera;
-    Mat4 orthoProjection = orthographic_projection(camera.position.x - camera.dimensions.x / 2.0f,
-                                                   camera.position.x + camera.dimensions.x / 2.0f, 
-                                                   camera.position.y - camera.dimensions.y / 2.0f,
-                                                   camera.position.y + camera.dimensions.y / 2.0f);
-    glUniformMatrix4fv(glContext.orthoProjectionID, 1, GL_FALSE, &orthoProjection.ax);
-
     {
+        // All passes share one upload, each draws its own range of the instance buffer with its own camera
+        char passUniforms[GL_PASS_UNIFORM_STRIDE * RENDER_PASS_COUNT] = {};
+        for(int passID = 0; passID < RENDER_PASS_COUNT; passID++){
+            GLPassUniforms* uniforms = (GLPassUniforms*)&passUniforms[passID * GL_PASS_UNIFORM_STRIDE];
+            CameraBounds bounds = get_camera_bounds(get_pass_camera(passID));
+            uniforms->orthoProjection = orthographic_projection(bounds.left, bounds.right, bounds.top, bounds.bottom);
+            uniforms->screenSize = vec_2(nativeSize);
+            uniforms->instanceOffset = get_render_pass(passID).instanceOffset;
+        }
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(passUniforms), passUniforms);
+        // Storage is only respecified when a frame needs more than ever before, every other frame updates the used range
+        if(renderData->transforms.count > glContext.transformCapacity){
+            while(glContext.transformCapacity < renderData->transforms.count) glContext.transformCapacity *= 2;
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, glContext.transformSBOID);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Transform) * glContext.transformCapacity, nullptr, GL_DYNAMIC_DRAW);
+        }
         glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Transform) * renderData->transforms.count, renderData->transforms.elements);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, renderData->transforms.count);
-        renderData->transforms.clear();
+        renderMetrics.current.uploadBytes += sizeof(passUniforms) + sizeof(Transform) * renderData->transforms.count;
+        bool drawTilemap = gl_upload_tilemap(nativeSize);
+
+        for(int passID = 0; passID < RENDER_PASS_COUNT; passID++){
+            RenderPass pass = get_render_pass(passID);
+            renderMetrics.current.passInstances[passID] = pass.instanceCount;
+            // Below everything else in the world pass, the way the tile instances used to be submitted first
+            if(passID == RENDER_PASS_WORLD && drawTilemap){
+                glUseProgram(glContext.tilemapProgramID);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                glUseProgram(glContext.programID);
+                renderMetrics.current.drawCalls++;
+            }
+            if(!pass.instanceCount) continue;
+            // Depth only orders quads within a pass, later passes always land on top
+            if(passID > RENDER_PASS_WORLD) glClear(GL_DEPTH_BUFFER_BIT);
+            glBindBufferRange(GL_UNIFORM_BUFFER, 0, glContext.passUBOID, passID * GL_PASS_UNIFORM_STRIDE, sizeof(GLPassUniforms));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, pass.instanceCount);
+            renderMetrics.current.drawCalls++;
+        }
+        clear_render_passes();
     }
 
+    {
+        // Pixel perfect upscale, GL counts window rows from the bottom while the viewport is measured from the top
+        UpscaleViewport viewport = get_upscale_viewport(input->screenSize, nativeSize);
+        int dstBottom = input->screenSize.y - viewport.pos.y - viewport.size.y;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, glContext.renderTargetFBOID);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBlitFramebuffer(0, 0, nativeSize.x, nativeSize.y,
+                          viewport.pos.x, dstBottom, viewport.pos.x + viewport.size.x, dstBottom + viewport.size.y,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
 }
 
 
@@ -51,6 +51,7 @@ static PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray_ptr;
 static PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer_ptr;
 static PFNGLBINDBUFFERPROC glBindBuffer_ptr;
 static PFNGLBINDBUFFERBASEPROC glBindBufferBase_ptr;
+static PFNGLBINDBUFFERRANGEPROC glBindBufferRange_ptr;
 static PFNGLBUFFERDATAPROC glBufferData_ptr;
 static PFNGLGETVERTEXATTRIBPOINTERVPROC glGetVertexAttribPointerv_ptr;
 static PFNGLUSEPROGRAMPROC glUseProgram_ptr;
@@ -62,6 +63,21 @@ static PFNGLDELETESHADERPROC glDeleteShader_ptr;
 static PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced_ptr;
 static PFNGLGENERATEMIPMAPPROC glGenerateMipmap_ptr;
 static PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback_ptr;
+static PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer_ptr;
+static PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers_ptr;
+static PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer_ptr;
+static PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage_ptr;
+static PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer_ptr;
+static PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers_ptr;
+static PFNGLTEXIMAGE3DPROC glTexImage3D_ptr;
+static PFNGLFENCESYNCPROC glFenceSync_ptr;
+static PFNGLCLIENTWAITSYNCPROC glClientWaitSync_ptr;
+static PFNGLDELETESYNCPROC glDeleteSync_ptr;
+static PFNGLTEXSTORAGE2DPROC glTexStorage2D_ptr;
+static PFNGLTEXSTORAGE3DPROC glTexStorage3D_ptr;
+static PFNGLTEXSUBIMAGE3DPROC glTexSubImage3D_ptr;
+static PFNGLMAPBUFFERRANGEPROC glMapBufferRange_ptr;
+static PFNGLUNMAPBUFFERPROC glUnmapBuffer_ptr;
 
 void gl_load_functions(){
     glCreateProgram_ptr = (PFNGLCREATEPROGRAMPROC)platform_load_gl_function("glCreateProgram");
@@ -106,6 +122,7 @@ void gl_load_functions(){
     glVertexAttribPointer_ptr = (PFNGLVERTEXATTRIBPOINTERPROC) platform_load_gl_function("glVertexAttribPointer");
     glBindBuffer_ptr = (PFNGLBINDBUFFERPROC) platform_load_gl_function("glBindBuffer");
     glBindBufferBase_ptr = (PFNGLBINDBUFFERBASEPROC) platform_load_gl_function("glBindBufferBase");
+    glBindBufferRange_ptr = (PFNGLBINDBUFFERRANGEPROC) platform_load_gl_function("glBindBufferRange");
     glBufferData_ptr = (PFNGLBUFFERDATAPROC) platform_load_gl_function("glBufferData");
     glGetVertexAttribPointerv_ptr = (PFNGLGETVERTEXATTRIBPOINTERVPROC) platform_load_gl_function("glGetVertexAttribPointerv");
     glUseProgram_ptr = (PFNGLUSEPROGRAMPROC) platform_load_gl_function("glUseProgram");
@@ -117,6 +134,21 @@ void gl_load_functions(){
     glDrawElementsInstanced_ptr = (PFNGLDRAWELEMENTSINSTANCEDPROC) platform_load_gl_function("glDrawElementsInstanced");
     glGenerateMipmap_ptr = (PFNGLGENERATEMIPMAPPROC) platform_load_gl_function("glGenerateMipmap");
     glDebugMessageCallback_ptr = (PFNGLDEBUGMESSAGECALLBACKPROC)platform_load_gl_function("glDebugMessageCallback");
+    glBlitFramebuffer_ptr = (PFNGLBLITFRAMEBUFFERPROC) platform_load_gl_function("glBlitFramebuffer");
+    glGenRenderbuffers_ptr = (PFNGLGENRENDERBUFFERSPROC) platform_load_gl_function("glGenRenderbuffers");
+    glBindRenderbuffer_ptr = (PFNGLBINDRENDERBUFFERPROC) platform_load_gl_function("glBindRenderbuffer");
+    glRenderbufferStorage_ptr = (PFNGLRENDERBUFFERSTORAGEPROC) platform_load_gl_function("glRenderbufferStorage");
+    glFramebufferRenderbuffer_ptr = (PFNGLFRAMEBUFFERRENDERBUFFERPROC) platform_load_gl_function("glFramebufferRenderbuffer");
+    glDeleteRenderbuffers_ptr = (PFNGLDELETERENDERBUFFERSPROC) platform_load_gl_function("glDeleteRenderbuffers");
+    glTexImage3D_ptr = (PFNGLTEXIMAGE3DPROC) platform_load_gl_function("glTexImage3D");
+    glFenceSync_ptr = (PFNGLFENCESYNCPROC) platform_load_gl_function("glFenceSync");
+    glClientWaitSync_ptr = (PFNGLCLIENTWAITSYNCPROC) platform_load_gl_function("glClientWaitSync");
+    glDeleteSync_ptr = (PFNGLDELETESYNCPROC) platform_load_gl_function("glDeleteSync");
+    glTexStorage2D_ptr = (PFNGLTEXSTORAGE2DPROC) platform_load_gl_function("glTexStorage2D");
+    glTexStorage3D_ptr = (PFNGLTEXSTORAGE3DPROC) platform_load_gl_function("glTexStorage3D");
+    glTexSubImage3D_ptr = (PFNGLTEXSUBIMAGE3DPROC) platform_load_gl_function("glTexSubImage3D");
+    glMapBufferRange_ptr = (PFNGLMAPBUFFERRANGEPROC) platform_load_gl_function("glMapBufferRange");
+    glUnmapBuffer_ptr = (PFNGLUNMAPBUFFERPROC) platform_load_gl_function("glUnmapBuffer");
 }
 
 GLAPI GLuint APIENTRY glCreateProgram (void){
@@ -287,6 +319,10 @@ void glBindBufferBase(GLenum target, GLuint index, GLuint buffer){
     glBindBufferBase_ptr(target, index, buffer);
 }
 
+void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size){
+    glBindBufferRange_ptr(target, index, buffer, offset, size);
+}
+
 void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage){
     glBufferData_ptr(target, size, data, usage);
 }
@@ -330,3 +366,65 @@ void glGenerateMipmap(GLenum target){
 void glDebugMessageCallback (GLDEBUGPROC callback, const void *userParam){
   glDebugMessageCallback_ptr(callback, userParam);
 }
+
+void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                       GLbitfield mask, GLenum filter){
+    glBlitFramebuffer_ptr(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers){
+    glGenRenderbuffers_ptr(n, renderbuffers);
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer){
+    glBindRenderbuffer_ptr(target, renderbuffer);
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height){
+    glRenderbufferStorage_ptr(target, internalformat, width, height);
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer){
+    glFramebufferRenderbuffer_ptr(target, attachment, renderbuffertarget, renderbuffer);
+}
+
+void glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers){
+    glDeleteRenderbuffers_ptr(n, renderbuffers);
+}
+
+void glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels){
+    glTexImage3D_ptr(target, level, internalformat, width, height, depth, border, format, type, pixels);
+}
+
+GLsync glFenceSync(GLenum condition, GLbitfield flags){
+    return glFenceSync_ptr(condition, flags);
+}
+
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout){
+    return glClientWaitSync_ptr(sync, flags, timeout);
+}
+
+void glDeleteSync(GLsync sync){
+    glDeleteSync_ptr(sync);
+}
+
+void glTexStorage2D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height){
+    glTexStorage2D_ptr(target, levels, internalformat, width, height);
+}
+
+void glTexStorage3D(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth){
+    glTexStorage3D_ptr(target, levels, internalformat, width, height, depth);
+}
+
+void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height,
+                     GLsizei depth, GLenum format, GLenum type, const void* pixels){
+    glTexSubImage3D_ptr(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+}
+
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+    return glMapBufferRange_ptr(target, offset, length, access);
+}
+
+GLboolean glUnmapBuffer(GLenum target){
+    return glUnmapBuffer_ptr(target);
+}
@@ -0,0 +1,137 @@
+#include "engine_lib.h"
+#include "input.h"
+#include "game.h"
+#include "game.cpp"
+#include "sw_renderer.cpp"
+#include "frame_capture.h"
+
+//#####################################################################################################################################
+//                                                  Headless Constants
+//#####################################################################################################################################
+constexpr int HEADLESS_WIDTH = WORLD_WIDTH;
+constexpr int HEADLESS_HEIGHT = WORLD_HEIGHT;
+constexpr int HEADLESS_GOLDEN_TOLERANCE = 1;    // the sRGB round trip may land one step off what the GPU produces
+constexpr IVec2 HEADLESS_LABEL_TILES = {12, 2};  // covers the rewind label in the top left corner of the UI
+
+//#####################################################################################################################################
+//                                                  Headless Structs
+//#####################################################################################################################################
+// Scripted input, the same scene always renders the same frames
+enum HeadlessScene{
+    HEADLESS_SCENE_IDLE,            // no input at all
+    HEADLESS_SCENE_REWIND_TEXT,     // solid tiles under the UI from the second frame, the rewind label over them from the third
+    HEADLESS_SCENE_COUNT
+};
+
+static const char* HEADLESS_SCENE_NAMES[HEADLESS_SCENE_COUNT] = {"idle", "rewind_text"};
+
+//#####################################################################################################################################
+//                                                  Headless Functions
+//#####################################################################################################################################
+// Right after the given frame was rendered, the chunks under the camera are resident by then
+void run_headless_scene(HeadlessScene scene, int frame){
+    if(scene != HEADLESS_SCENE_REWIND_TEXT) return;
+    if(frame == 0){
+        ViewRect view = get_camera_view(renderData->gameCamera);
+        IVec2 corner = get_tile_pos({(int)view.min.x, (int)view.min.y});
+        for(int y = corner.y; y < corner.y + HEADLESS_LABEL_TILES.y; y++){
+            for(int x = corner.x; x < corner.x + HEADLESS_LABEL_TILES.x; x++){
+                Tile* tile = get_tile(x, y);
+                if(!tile) continue;
+                tile->isVisible = true;
+                upload_tilemap_tile(x, y);
+                update_neigbour_masks({x, y});
+            }
+        }
+    }
+    // The rewind buffer needs two frames before it can step back
+    input->keys[KEY_R].isDown = frame >= 1;
+}
+
+//#####################################################################################################################################
+//                                                  Headless Main
+//#####################################################################################################################################
+// headless.exe [frames] [outputDirectory] [goldenDirectory] [scene]
+// Runs the game without a window or GL context and renders every frame with the software renderer at native
+// resolution. Frames are written as frame_<n>.ppm, or into one video when the output ends in .y4m, by a writer
+// thread so rendering is not held up by the disk. With a golden directory every frame is compared against the
+// image of the same name there and the exit code is the number of frames that differ or have no valid golden.
+// A golden directory of - skips the comparison. scene is one of HEADLESS_SCENE_NAMES and scripts the input, idle by default.
+// The goldens in assets/goldens/<scene> are checked with: headless.exe 3 frames assets/goldens/rewind_text rewind_text
+int main(int argc, char** argv){
+    int frameCount = argc > 1 ? atoi(argv[1]) : 60;
+    const char* outputDirectory = argc > 2 ? argv[2] : "frames";
+    char* goldenDirectory = argc > 3 && strcmp(argv[3], "-") != 0 ? argv[3] : nullptr;
+    HeadlessScene scene = HEADLESS_SCENE_IDLE;
+    if(argc > 4){
+        while(scene < HEADLESS_SCENE_COUNT && strcmp(argv[4], HEADLESS_SCENE_NAMES[scene]) != 0) scene = (HeadlessScene)(scene + 1);
+        SM_ASSERT_GUARD(scene < HEADLESS_SCENE_COUNT, -1, "Unknown scene %s", argv[4]);
+    }
+
+    BumpAllocator transientStorage = make_bump_allocator(MB(50));
+    BumpAllocator persistentStorage = make_bump_allocator(MB(50));
+
+    gameState = (GameState*)bump_alloc(&persistentStorage, sizeof(GameState));
+    SM_ASSERT_GUARD(gameState, -1, "Failed to allocate GameState");
+    input = (Input*)bump_alloc(&persistentStorage, sizeof(Input));
+    SM_ASSERT_GUARD(input, -1, "Failed to allocate Input");
+    renderData = (RenderData*)bump_alloc(&persistentStorage, sizeof(RenderData));
+    SM_ASSERT_GUARD(renderData, -1, "Failed to allocate RenderData");
+    particleSystem = (ParticleSystem*)bump_alloc(&persistentStorage, sizeof(ParticleSystem));
+    SM_ASSERT_GUARD(particleSystem, -1, "Failed to allocate ParticleSystem");
+    chunkWorld = (ChunkWorld*)bump_alloc(&persistentStorage, sizeof(ChunkWorld));
+    SM_ASSERT_GUARD(chunkWorld, -1, "Failed to allocate ChunkWorld");
+    rewindBuffer = (RewindBuffer*)bump_alloc(&persistentStorage, sizeof(RewindBuffer));
+    SM_ASSERT_GUARD(rewindBuffer, -1, "Failed to allocate RewindBuffer");
+    *rewindBuffer = make_rewind_buffer(&persistentStorage, sizeof(GameState), REWIND_FRAMES, REWIND_KEYFRAME_INTERVAL, REWIND_DATA_SIZE);
+
+    // Spilled edits would make the output depend on earlier interactive sessions, only the level file is used
+    init_chunk_world(chunkWorld, LEVEL_SIZE, "levels/headless");
+    // Scripted scenes start from an empty world, so their goldens do not depend on the level
+    LevelView level = {};
+    if(scene == HEADLESS_SCENE_IDLE && file_exists("levels/default.lvl")){
+        int levelSize = 0;
+        char* levelData = read_file("levels/default.lvl", &levelSize, &persistentStorage);
+        if(levelData) open_level_view(&level, levelData, levelSize);
+    }
+    attach_level(chunkWorld, level);
+    chunkWorld->loaderRunning = true;
+    std::thread chunkLoader(run_chunk_loader, chunkWorld);
+
+    SM_ASSERT_GUARD(sw_init(&persistentStorage, HEADLESS_WIDTH, HEADLESS_HEIGHT), -1, "Failed to initialize the Software Renderer");
+    input->screenSize = {HEADLESS_WIDTH, HEADLESS_HEIGHT};
+    SM_ASSERT_GUARD(start_frame_capture(outputDirectory, {HEADLESS_WIDTH, HEADLESS_HEIGHT}, false), -1, "Failed to start the Frame Capture");
+
+    int failedFrames = 0;
+    for(int frame = 0; frame < frameCount; frame++){
+        update_game(gameState, renderData, input, particleSystem, chunkWorld, rewindBuffer);
+        sw_render(&transientStorage);
+        // Chunks requested this frame are resident for the next one, so the output does not depend on loader timing
+        wait_for_chunk_loader(chunkWorld);
+        run_headless_scene(scene, frame);
+
+        unsigned int* pixels = begin_capture_frame({HEADLESS_WIDTH, HEADLESS_HEIGHT});
+        memcpy(pixels, swContext.framebuffer.pixels, sizeof(unsigned int) * HEADLESS_WIDTH * HEADLESS_HEIGHT);
+        submit_capture_frame();
+        if(goldenDirectory){
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%05d.ppm", goldenDirectory, frame);
+            int differentCount = sw_compare_ppm(path, HEADLESS_GOLDEN_TOLERANCE, &transientStorage);
+            if(differentCount == SW_COMPARE_INVALID){
+                SM_ERROR("Frame %d: missing or invalid golden %s", frame, path);
+                failedFrames++;
+            }
+            else if(differentCount){
+                SM_ERROR("Frame %d: %d pixels differ from %s", frame, differentCount, path);
+                failedFrames++;
+            }
+        }
+        transientStorage.used = 0;
+    }
+
+    stop_frame_capture();
+    chunkWorld->loaderRunning = false;
+    chunkLoader.join();
+    SM_TRACE("Rendered %d frames into %s", frameCount, outputDirectory);
+    return failedFrames;
+}
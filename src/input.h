@@ -53,4 +53,11 @@ bool key_released_this_frame(KeyCodeID keyCode){
     return (!key.isDown && key.halfTransitionCount >= 1);
 }
 
-bool key_is_down(KeyCodeID keyCode){ return input->keys[keyCode].isDown; }
\ No newline at end of file
+bool key_is_down(KeyCodeID keyCode){ return input->keys[keyCode].isDown; }
+
+bool any_key_down(){
+    for(int keyCode = 0; keyCode < KEY_COUNT; keyCode++){
+        if(input->keys[keyCode].isDown) return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#pragma once
+#include "engine_lib.h"
+
+//#####################################################################################################################################
+//                                                  Level Constants
+//#####################################################################################################################################
+constexpr unsigned int LEVEL_MAGIC = 0x4C56454C; // "LEVL"
+constexpr unsigned short LEVEL_VERSION = 1;
+constexpr int LEVEL_CHUNK_SIZE = 32;
+constexpr int LEVEL_CHUNK_BITMAP_SIZE = LEVEL_CHUNK_SIZE * LEVEL_CHUNK_SIZE / 8;
+constexpr int LEVEL_MAX_PACKED_SIZE = LEVEL_CHUNK_BITMAP_SIZE + LEVEL_CHUNK_BITMAP_SIZE / 128 + 1;
+
+//#####################################################################################################################################
+//                                                  Level Structs
+//#####################################################################################################################################
+enum LevelLayer{
+    LEVEL_LAYER_SOLID,
+
+    LEVEL_LAYER_COUNT
+};
+
+// File layout: LevelHeader, packed chunk payloads, then the chunk directory sorted by (y, x). Chunks without a single
+// set bit are left out, so empty space costs nothing. A payload holds one 1 bit per tile bitmap for every layer, each
+// PackBits compressed and prefixed by its packed size as an unsigned short. Neighbour masks are never stored,
+// they are derived from the solid layer when a chunk is loaded.
+struct LevelHeader{
+    unsigned int magic;
+    unsigned short version;
+    unsigned short layerCount;
+    IVec2 sizeInTiles;
+    int chunkSize;
+    int chunkCount;
+    unsigned long long directoryOffset;
+};
+
+struct LevelChunkEntry{
+    IVec2 chunkCoord;
+    unsigned int packedSize;
+    unsigned int padding;
+    unsigned long long offset;
+};
+
+// A level file mapped into memory, nothing is decoded until a chunk is asked for
+struct LevelView{
+    char* data;
+    long long size;
+    LevelHeader* header;
+    LevelChunkEntry* directory;
+};
+
+struct LevelWriter{
+    FILE* file;
+    LevelHeader header;
+    int directoryCapacity;
+    LevelChunkEntry* directory;
+    unsigned long long offset;
+};
+
+//#####################################################################################################################################
+//                                                  Level Compression
+//#####################################################################################################################################
+// PackBits: a control byte c < 128 is followed by c + 1 literal bytes, c > 128 repeats the next byte 257 - c times
+int pack_bits(unsigned char* in, int size, unsigned char* out){
+    int outSize = 0;
+    int idx = 0;
+    while(idx < size){
+        int run = 1;
+        while(idx + run < size && run < 128 && in[idx + run] == in[idx]) run++;
+        if(run >= 3){
+            out[outSize++] = (unsigned char)(257 - run);
+            out[outSize++] = in[idx];
+            idx += run;
+            continue;
+        }
+
+        int literalStart = idx;
+        int literalCount = 0;
+        while(idx < size && literalCount < 128){
+            if(idx + 2 < size && in[idx] == in[idx + 1] && in[idx] == in[idx + 2]) break;
+            idx++;
+            literalCount++;
+        }
+        out[outSize++] = (unsigned char)(literalCount - 1);
+        memcpy(out + outSize, in + literalStart, literalCount);
+        outSize += literalCount;
+    }
+    return outSize;
+}
+
+bool unpack_bits(unsigned char* in, int inSize, unsigned char* out, int outSize){
+    int inIdx = 0, outIdx = 0;
+    while(inIdx < inSize){
+        int control = in[inIdx++];
+        if(control < 128){
+            int count = control + 1;
+            if(inIdx + count > inSize || outIdx + count > outSize) return false;
+            memcpy(out + outIdx, in + inIdx, count);
+            inIdx += count;
+            outIdx += count;
+        } else if(control > 128){
+            int count = 257 - control;
+            if(inIdx >= inSize || outIdx + count > outSize) return false;
+            memset(out + outIdx, in[inIdx++], count);
+            outIdx += count;
+        }
+    }
+    return outIdx == outSize;
+}
+
+//#####################################################################################################################################
+//                                                  Level Writing
+//#####################################################################################################################################
+bool begin_level_file(LevelWriter* writer, char* path, IVec2 sizeInTiles){
+    *writer = {};
+    writer->file = fopen(path, "wb");
+    if(!writer->file){
+        SM_ERROR("Failed opening File: %s", path);
+        return false;
+    }
+    writer->header.magic = LEVEL_MAGIC;
+    writer->header.version = LEVEL_VERSION;
+    writer->header.layerCount = LEVEL_LAYER_COUNT;
+    writer->header.sizeInTiles = sizeInTiles;
+    writer->header.chunkSize = LEVEL_CHUNK_SIZE;
+    fwrite(&writer->header, sizeof(LevelHeader), 1, writer->file);
+    writer->offset = sizeof(LevelHeader);
+    return true;
+}
+
+// Chunks have to be added in (y, x) order, layerBits holds LEVEL_LAYER_COUNT bitmaps of LEVEL_CHUNK_BITMAP_SIZE bytes
+void add_level_chunk(LevelWriter* writer, IVec2 chunkCoord, unsigned char* layerBits){
+    if(writer->header.chunkCount == writer->directoryCapacity){
+        writer->directoryCapacity = writer->directoryCapacity ? writer->directoryCapacity * 2 : 1024;
+        writer->directory = (LevelChunkEntry*)realloc(writer->directory, sizeof(LevelChunkEntry) * writer->directoryCapacity);
+        SM_ASSERT(writer->directory, "Failed to grow the Level directory");
+    }
+
+    unsigned char payload[LEVEL_LAYER_COUNT * (sizeof(unsigned short) + LEVEL_MAX_PACKED_SIZE)];
+    int payloadSize = 0;
+    for(int layer = 0; layer < LEVEL_LAYER_COUNT; layer++){
+        unsigned short packedSize = (unsigned short)pack_bits(layerBits + layer * LEVEL_CHUNK_BITMAP_SIZE, LEVEL_CHUNK_BITMAP_SIZE,
+                                                              payload + payloadSize + sizeof(unsigned short));
+        memcpy(payload + payloadSize, &packedSize, sizeof(unsigned short));
+        payloadSize += sizeof(unsigned short) + packedSize;
+    }
+    fwrite(payload, 1, payloadSize, writer->file);
+
+    LevelChunkEntry* entry = &writer->directory[writer->header.chunkCount++];
+    *entry = {};
+    entry->chunkCoord = chunkCoord;
+    entry->packedSize = payloadSize;
+    entry->offset = writer->offset;
+    writer->offset += payloadSize;
+}
+
+bool end_level_file(LevelWriter* writer){
+    writer->header.directoryOffset = writer->offset;
+    fwrite(writer->directory, sizeof(LevelChunkEntry), writer->header.chunkCount, writer->file);
+    fseek(writer->file, 0, SEEK_SET);
+    bool result = fwrite(&writer->header, sizeof(LevelHeader), 1, writer->file) == 1;
+    result = (fclose(writer->file) == 0) && result;
+    free(writer->directory);
+    *writer = {};
+    return result;
+}
+
+//#####################################################################################################################################
+//                                                  Level Reading
+//#####################################################################################################################################
+bool open_level_view(LevelView* level, char* data, long long size){
+    *level = {};
+    SM_ASSERT_GUARD(data && size >= (long long)sizeof(LevelHeader), false, "Level file is too small");
+    LevelHeader* header = (LevelHeader*)data;
+    SM_ASSERT_GUARD(header->magic == LEVEL_MAGIC, false, "Not a Level file");
+    SM_ASSERT_GUARD(header->version == LEVEL_VERSION, false, "Unsupported Level version %d", header->version);
+    SM_ASSERT_GUARD(header->chunkSize == LEVEL_CHUNK_SIZE, false, "Unsupported Level chunk size %d", header->chunkSize);
+    SM_ASSERT_GUARD(header->directoryOffset + (unsigned long long)header->chunkCount * sizeof(LevelChunkEntry) <= (unsigned long long)size,
+                    false, "Level directory is truncated");
+    level->data = data;
+    level->size = size;
+    level->header = header;
+    level->directory = (LevelChunkEntry*)(data + header->directoryOffset);
+    return true;
+}
+
+LevelChunkEntry* find_level_chunk(LevelView* level, IVec2 chunkCoord){
+    if(!level->header) return nullptr;
+    int low = 0, high = level->header->chunkCount - 1;
+    while(low <= high){
+        int mid = (low + high) / 2;
+        IVec2 coord = level->directory[mid].chunkCoord;
+        if(coord.y == chunkCoord.y && coord.x == chunkCoord.x) return &level->directory[mid];
+        if(coord.y < chunkCoord.y || (coord.y == chunkCoord.y && coord.x < chunkCoord.x)) low = mid + 1;
+        else high = mid - 1;
+    }
+    return nullptr;
+}
+
+// Unpacks one layer bitmap, chunks missing from the directory are all zero
+bool read_level_chunk_layer(LevelView* level, IVec2 chunkCoord, int layer, unsigned char* bits){
+    memset(bits, 0, LEVEL_CHUNK_BITMAP_SIZE);
+    LevelChunkEntry* entry = find_level_chunk(level, chunkCoord);
+    if(!entry) return true;
+    SM_ASSERT_GUARD(layer < level->header->layerCount, false, "Level has no layer %d", layer);
+    SM_ASSERT_GUARD(entry->offset + entry->packedSize <= (unsigned long long)level->size, false, "Level chunk is truncated");
+
+    unsigned char* payload = (unsigned char*)level->data + entry->offset;
+    unsigned int offset = 0;
+    for(int idx = 0; idx <= layer; idx++){
+        unsigned short packedSize;
+        SM_ASSERT_GUARD(offset + sizeof(unsigned short) <= entry->packedSize, false, "Level chunk is truncated");
+        memcpy(&packedSize, payload + offset, sizeof(unsigned short));
+        offset += sizeof(unsigned short);
+        SM_ASSERT_GUARD(offset + packedSize <= entry->packedSize, false, "Level chunk is truncated");
+        if(idx == layer) return unpack_bits(payload + offset, packedSize, bits, LEVEL_CHUNK_BITMAP_SIZE);
+        offset += packedSize;
+    }
+    return false;
+}
@@ -14,6 +14,8 @@ static KeyCodeID KeyCodeLookupTable[KEY_COUNT];
 #endif
 
 #include "gl_renderer.cpp"
+#include "frame_pacing.h"
+#include "render_metrics.h"
 
 //#####################################################################################################################################
 //                                                  Game DLL Stuff
@@ -21,15 +23,53 @@ static KeyCodeID KeyCodeLookupTable[KEY_COUNT];
 typedef decltype(update_game) update_game_type;
 static update_game_type* update_game_ptr;
 
+//#####################################################################################################################################
+//                                                  Level Globals
+//#####################################################################################################################################
+static char levelPath[] = "levels/default.lvl";
+
+//#####################################################################################################################################
+//                                                  Idle Frame Globals
+//#####################################################################################################################################
+// Idle frames are neither simulated nor drawn, a frame still runs this often so edited assets are picked up
+constexpr long long IDLE_REFRESH_NS = 250000000;
+static bool skipIdleFrames = true;
+
+//#####################################################################################################################################
+//                                                  Frame Capture Globals
+//#####################################################################################################################################
+static int captureCount;
+
 
 //#####################################################################################################################################
 //                                                  Cross Platform Functions
 //#####################################################################################################################################
 void reload_game_dll(BumpAllocator* transientStorage);
+void load_level(char* path);
+bool save_level(char* path);
 
-int main(){
+// game.exe [metricsFile]
+// With a metrics file every presented frame is appended to it, see open_metrics_file
+int main(int argc, char** argv){
+    long long startNs = platform_get_time_ns();
     BumpAllocator transientStorage = make_bump_allocator(MB(50));
     BumpAllocator persistentStorage = make_bump_allocator(MB(50));
+    BumpAllocator startupStorage = make_bump_allocator(MB(16));
+
+    // Only GL calls have to wait for the window, files are read and decoded and game.dll is loaded meanwhile.
+    // The main thread stays off transientStorage and startupStorage until both are joined
+    GLStartupAssets startupAssets = {};
+    long long assetsNs = 0, gameDLLNs = 0;
+    std::thread assetLoader([&](){
+        long long start = platform_get_time_ns();
+        gl_load_startup_assets(&startupAssets, &startupStorage);
+        assetsNs = platform_get_time_ns() - start;
+    });
+    std::thread gameDLLLoader([&](){
+        long long start = platform_get_time_ns();
+        reload_game_dll(&transientStorage);
+        gameDLLNs = platform_get_time_ns() - start;
+    });
 
     gameState = (GameState*)bump_alloc(&persistentStorage, sizeof(GameState));
     SM_ASSERT_GUARD(gameState, -1, "Failed to allocate GameState");
@@ -37,25 +77,131 @@ int main(){
     SM_ASSERT_GUARD(input, -1, "Failed to allocate Input");
     renderData = (RenderData*)bump_alloc(&persistentStorage, sizeof(RenderData));
     SM_ASSERT_GUARD(renderData, -1, "Failed to allocate RenderData");
+    particleSystem = (ParticleSystem*)bump_alloc(&persistentStorage, sizeof(ParticleSystem));
+    SM_ASSERT_GUARD(particleSystem, -1, "Failed to allocate ParticleSystem");
+    chunkWorld = (ChunkWorld*)bump_alloc(&persistentStorage, sizeof(ChunkWorld));
+    SM_ASSERT_GUARD(chunkWorld, -1, "Failed to allocate ChunkWorld");
+    rewindBuffer = (RewindBuffer*)bump_alloc(&persistentStorage, sizeof(RewindBuffer));
+    SM_ASSERT_GUARD(rewindBuffer, -1, "Failed to allocate RewindBuffer");
+    *rewindBuffer = make_rewind_buffer(&persistentStorage, sizeof(GameState), REWIND_FRAMES, REWIND_KEYFRAME_INTERVAL, REWIND_DATA_SIZE);
+    init_chunk_world(chunkWorld, LEVEL_SIZE, "levels/default");
+    load_level(levelPath);
+    chunkWorld->loaderRunning = true;
+    std::thread chunkLoader(run_chunk_loader, chunkWorld);
 
     platform_fill_keycode_lookup_table();
+    long long windowStartNs = platform_get_time_ns();
     platform_create_window(1280, 720, "Game");
-
-    gl_init(&transientStorage);
+    long long windowNs = platform_get_time_ns() - windowStartNs;
+
+    assetLoader.join();
+    gameDLLLoader.join();
+    long long glStartNs = platform_get_time_ns();
+    gl_init(&startupAssets);
+    long long glNs = platform_get_time_ns() - glStartNs;
+    free(startupStorage.memory);
+    init_frame_pacer({});
+    if(argc > 1) open_metrics_file(argv[1]);
+    long long lastFrameNs = 0;
+    bool firstFrame = true;
     while (running){
+        begin_metrics_phase(FRAME_PHASE_RELOAD);
         reload_game_dll(&transientStorage);
-        platform_update_window();
-        update_game(gameState, renderData, input);
+        begin_metrics_phase(FRAME_PHASE_PACING);
+        begin_frame();
+        begin_metrics_phase(FRAME_PHASE_INPUT);
+        bool hadEvents = platform_update_window();
+        if(key_pressed_this_frame(KEY_F9)) set_vsync_mode((VSyncMode)((framePacer.vsync + 1) % VSYNC_COUNT));
+        if(key_pressed_this_frame(KEY_F10)) framePacer.config.logTimings = !framePacer.config.logTimings;
+        if(key_pressed_this_frame(KEY_F11)) skipIdleFrames = !skipIdleFrames;
+        if(key_pressed_this_frame(KEY_F12)) renderMetrics.showGraph = !renderMetrics.showGraph;
+        if(key_pressed_this_frame(KEY_F8)){
+            // Native resolution, with shift held the window as it is presented
+            if(frameCapture.running) gl_stop_capture();
+            else if(create_directory("captures")){
+                char capturePath[256];
+                snprintf(capturePath, sizeof(capturePath), "captures/capture_%03d.y4m", captureCount++);
+                gl_start_capture(capturePath, key_is_down(KEY_SHIFT));
+            }
+        }
+
+        // The last frame is still on screen, nothing is rebuilt or presented until an event arrives. A capture
+        // needs every frame to keep its timing
+        long long sinceLastFrameNs = platform_get_time_ns() - lastFrameNs;
+        if(skipIdleFrames && !frameCapture.running && !hadEvents && renderData->idle && sinceLastFrameNs < IDLE_REFRESH_NS){
+            begin_metrics_phase(FRAME_PHASE_IDLE);
+            platform_wait_for_events(IDLE_REFRESH_NS - sinceLastFrameNs);
+            continue;
+        }
+        lastFrameNs = platform_get_time_ns();
+        begin_metrics_phase(FRAME_PHASE_UPDATE);
+        update_game(gameState, renderData, input, particleSystem, chunkWorld, rewindBuffer);
+        if(chunkWorld->saveRequested){
+            chunkWorld->saveRequested = false;
+            wait_for_chunk_loader(chunkWorld);
+            save_level(levelPath);
+        }
+        draw_metrics_graph(FRAME_TIME * 1000.0f);
+        begin_metrics_phase(FRAME_PHASE_RENDER);
         gl_render(&transientStorage);
+        begin_metrics_phase(FRAME_PHASE_PRESENT);
+        gl_capture_frame();
         platform_swap_buffers();
+        end_frame();
+        end_metrics_frame(&transientStorage, &persistentStorage);
+        if(firstFrame){
+            firstFrame = false;
+            SM_TRACE("First frame after %.1f ms: window %.1f ms, assets %.1f ms and game.dll %.1f ms alongside, gl_init %.1f ms",
+                     (platform_get_time_ns() - startNs) / 1000000.0, windowNs / 1000000.0, assetsNs / 1000000.0,
+                     gameDLLNs / 1000000.0, glNs / 1000000.0);
+        }
 
         transientStorage.used = 0;
     }
+
+    wait_for_chunk_loader(chunkWorld);
+    chunkWorld->loaderRunning = false;
+    chunkLoader.join();
+    if(!save_level(levelPath)) flush_chunk_world(chunkWorld);
+    gl_shutdown();
+    close_metrics_file();
     return 0;
 }
 
-void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn){
-    update_game_ptr(gameStateIn, renderDataIn, inputIn);
+void update_game(GameState* gameStateIn, RenderData* renderDataIn, Input* inputIn, ParticleSystem* particleSystemIn,
+                 ChunkWorld* chunkWorldIn, RewindBuffer* rewindBufferIn){
+    update_game_ptr(gameStateIn, renderDataIn, inputIn, particleSystemIn, chunkWorldIn, rewindBufferIn);
+}
+
+// A missing, empty or broken level file leaves the world empty, edits are still spilled and end up in the next save
+void load_level(char* path){
+    long long size;
+    char* data = (char*)platform_map_file(path, &size);
+    LevelView level = {};
+    if(data && !open_level_view(&level, data, size)){
+        platform_unmap_file(data);
+        level = {};
+    }
+    attach_level(chunkWorld, level);
+}
+
+// The loader thread has to be idle, the new level is written next to the old one and swapped in afterwards
+bool save_level(char* path){
+    char tmpPath[256];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    if(!write_chunk_world_level(chunkWorld, tmpPath)){
+        SM_ERROR("Failed to save Level: %s", path);
+        return false;
+    }
+
+    platform_unmap_file(chunkWorld->level.data);
+    attach_level(chunkWorld, {});
+    remove(path);
+    bool result = rename(tmpPath, path) == 0;
+    SM_ASSERT(result, "Failed to replace Level: %s", path);
+    load_level(result ? path : tmpPath);
+    SM_TRACE("Saved Level %s, %d chunks", path, chunkWorld->level.header ? chunkWorld->level.header->chunkCount : 0);
+    return result;
 }
 
 void reload_game_dll(BumpAllocator* transientStorage){
@@ -0,0 +1,108 @@
+#pragma once
+#include "engine_lib.h"
+#include "assets.h"
+
+//#####################################################################################################################################
+//                                                  Palette Constants
+//#####################################################################################################################################
+constexpr int MAX_PALETTE_COLORS = 256;                 // index 0 is every fully transparent texel
+constexpr int PALETTE_HASH_SIZE = 1024;                 // power of two, at most a quarter full
+
+//#####################################################################################################################################
+//                                                  Palette Structs
+//#####################################################################################################################################
+// Every atlas page as one color index per texel plus PALETTE_COUNT rows of colors shared by all pages, RGBA8 sRGB
+// with R in the lowest byte
+struct IndexedAtlas{
+    int width, height;          // of every layer, smaller pages sit in the top left corner of theirs
+    int pageCount;
+    int colorCount;
+    unsigned char* indices;     // width * height per page
+    unsigned int palettes[PALETTE_COUNT][MAX_PALETTE_COLORS];
+};
+
+//#####################################################################################################################################
+//                                                  Palette Functions
+//#####################################################################################################################################
+// Fills atlas->indices (width * height * pageCount bytes, owned by the caller) and every palette row. Fails when the
+// pages use more than MAX_PALETTE_COLORS colors together, with all fully transparent texels counting as one.
+bool index_atlas(unsigned int** pages, IVec2* pageSizes, IndexedAtlas* atlas){
+    unsigned int hashColors[PALETTE_HASH_SIZE];
+    unsigned char hashIndices[PALETTE_HASH_SIZE];
+    bool hashUsed[PALETTE_HASH_SIZE] = {};
+    unsigned int* colors = atlas->palettes[PALETTE_DEFAULT];
+    colors[0] = 0;
+    atlas->colorCount = 1;
+    memset(atlas->indices, 0, atlas->width * atlas->height * atlas->pageCount);
+
+    // Transparent hashes to slot 0 and keeps index 0
+    hashUsed[0] = true;
+    hashColors[0] = 0;
+    hashIndices[0] = 0;
+
+    // Pixel art repeats the same color in runs, the last lookup is usually the next one too
+    unsigned int lastColor = 0;
+    unsigned char lastIndex = 0;
+    for(int pageIdx = 0; pageIdx < atlas->pageCount; pageIdx++){
+        unsigned int* texels = pages[pageIdx];
+        IVec2 size = pageSizes[pageIdx];
+        SM_ASSERT_GUARD(size.x <= atlas->width && size.y <= atlas->height, false, "Page %d does not fit a %dx%d layer", pageIdx, atlas->width, atlas->height);
+        unsigned char* layer = atlas->indices + pageIdx * atlas->width * atlas->height;
+        for(int idx = 0; idx < size.x * size.y; idx++){
+            unsigned int color = texels[idx] & 0xFF000000 ? texels[idx] : 0;
+            if(color != lastColor){
+                unsigned int slot = (color * 2654435761u) >> 22;
+                while(hashUsed[slot] && hashColors[slot] != color) slot = (slot + 1) & (PALETTE_HASH_SIZE - 1);
+                if(!hashUsed[slot]){
+                    SM_ASSERT_GUARD(atlas->colorCount < MAX_PALETTE_COLORS, false, "Atlas uses more than %d colors", MAX_PALETTE_COLORS);
+                    hashUsed[slot] = true;
+                    hashColors[slot] = color;
+                    hashIndices[slot] = (unsigned char)atlas->colorCount;
+                    colors[atlas->colorCount++] = color;
+                }
+                lastColor = color;
+                lastIndex = hashIndices[slot];
+            }
+            layer[(idx / size.x) * atlas->width + idx % size.x] = lastIndex;
+        }
+    }
+
+    for(int paletteID = 0; paletteID < PALETTE_COUNT; paletteID++){
+        for(int idx = 0; idx < MAX_PALETTE_COLORS; idx++){
+            atlas->palettes[paletteID][idx] = idx < atlas->colorCount ? get_palette_color((PaletteID)paletteID, colors[idx]) : 0;
+        }
+    }
+    return true;
+}
+
+// Loads and indexes every page of ATLAS_PAGES, everything is allocated from storage. Needs stb_image.h included
+// before this file, the renderers already do that to define its implementation
+IndexedAtlas* load_indexed_atlas(BumpAllocator* storage){
+    unsigned int* pages[ATLAS_PAGE_COUNT] = {};
+    IVec2 pageSizes[ATLAS_PAGE_COUNT];
+    IVec2 layerSize = {};
+    bool loaded = true;
+    for(int pageIdx = 0; pageIdx < ATLAS_PAGE_COUNT; pageIdx++){
+        int channels;
+        pages[pageIdx] = (unsigned int*)stbi_load(ATLAS_PAGES[pageIdx], &pageSizes[pageIdx].x, &pageSizes[pageIdx].y, &channels, 4);
+        loaded = pages[pageIdx] != nullptr;
+        if(!loaded){
+            SM_ERROR("Failed to load %s", ATLAS_PAGES[pageIdx]);
+            break;
+        }
+        layerSize = {max(layerSize.x, pageSizes[pageIdx].x), max(layerSize.y, pageSizes[pageIdx].y)};
+    }
+
+    IndexedAtlas* atlas = loaded ? (IndexedAtlas*)bump_alloc(storage, sizeof(IndexedAtlas)) : nullptr;
+    if(atlas){
+        atlas->width = layerSize.x;
+        atlas->height = layerSize.y;
+        atlas->pageCount = ATLAS_PAGE_COUNT;
+        atlas->indices = (unsigned char*)bump_alloc(storage, layerSize.x * layerSize.y * ATLAS_PAGE_COUNT);
+        if(!atlas->indices || !index_atlas(pages, pageSizes, atlas)) atlas = nullptr;
+    }
+    for(int pageIdx = 0; pageIdx < ATLAS_PAGE_COUNT; pageIdx++){
+        if(pages[pageIdx]) stbi_image_free(pages[pageIdx]);
+    }
+    return atlas;
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include "engine_lib.h"
+#include "assets.h"
+#include "render_interface.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+//#####################################################################################################################################
+//                                                  Particle Constants
+//#####################################################################################################################################
+constexpr int MAX_PARTICLES = 1 << 18;
+constexpr int MAX_PARTICLE_EMITTERS = 64;
+
+//#####################################################################################################################################
+//                                                  Particle Structs
+//#####################################################################################################################################
+struct ParticleEmitterDesc{
+    SpriteID spriteID;
+    int frameCount = 1;         // frames laid out to the right of the sprite in the atlas
+    float frameSpeed;           // frames per second
+
+    Vec2 pos;
+    Vec2 spawnExtent;           // particles spawn uniformly inside pos +- spawnExtent
+    Vec2 velMin, velMax;        // pixels per second
+    float gravity;              // pixels per second^2, positive is down
+    float lifetime;             // seconds
+    float rate;                 // particles per second, 0 for burst only emitters
+};
+
+struct ParticleEmitter{
+    bool active;
+    int liveCount;              // a slot is only reused once all of its particles are gone, they still read its sprite
+    ParticleEmitterDesc desc;
+    float spawnAccumulator;
+};
+
+// Particle state is stored as structure-of-arrays so the update can run on 4 particles at a time with SSE2
+struct ParticleSystem{
+    unsigned int randomState;
+    int count;
+    ParticleEmitter emitters[MAX_PARTICLE_EMITTERS];
+
+    float posX[MAX_PARTICLES];
+    float posY[MAX_PARTICLES];
+    float velX[MAX_PARTICLES];
+    float velY[MAX_PARTICLES];
+    float gravity[MAX_PARTICLES];
+    float life[MAX_PARTICLES];
+    float frame[MAX_PARTICLES];
+    float frameSpeed[MAX_PARTICLES];
+    unsigned char emitterIdx[MAX_PARTICLES];
+};
+
+//#####################################################################################################################################
+//                                                  Particle Globals
+//#####################################################################################################################################
+static ParticleSystem* particleSystem;
+
+//#####################################################################################################################################
+//                                                  Particle Utility
+//#####################################################################################################################################
+float particle_random01(){
+    unsigned int x = particleSystem->randomState ? particleSystem->randomState : 0x9E3779B9;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    particleSystem->randomState = x;
+    return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+float particle_random_range(float min, float max){ return min + (max - min) * particle_random01(); }
+
+//#####################################################################################################################################
+//                                                  Particle Functions
+//#####################################################################################################################################
+int create_particle_emitter(ParticleEmitterDesc desc){
+    for(int idx = 0; idx < MAX_PARTICLE_EMITTERS; idx++){
+        ParticleEmitter* emitter = &particleSystem->emitters[idx];
+        if(emitter->active || emitter->liveCount > 0) continue;
+        *emitter = {};
+        emitter->active = true;
+        emitter->desc = desc;
+        return idx;
+    }
+    SM_ASSERT(false, "No free Particle Emitter, all %d are in use", MAX_PARTICLE_EMITTERS);
+    return -1;
+}
+
+void destroy_particle_emitter(int emitterIdx){
+    SM_ASSERT_GUARD(emitterIdx >= 0 && emitterIdx < MAX_PARTICLE_EMITTERS, , "Invalid Particle Emitter: %d", emitterIdx);
+    particleSystem->emitters[emitterIdx].active = false;
+    particleSystem->emitters[emitterIdx].desc.rate = 0.0f;
+}
+
+void emit_particles(int emitterIdx, int count){
+    SM_ASSERT_GUARD(emitterIdx >= 0 && emitterIdx < MAX_PARTICLE_EMITTERS, , "Invalid Particle Emitter: %d", emitterIdx);
+    ParticleEmitterDesc* desc = &particleSystem->emitters[emitterIdx].desc;
+
+    int available = MAX_PARTICLES - particleSystem->count;
+    if(count > available) count = available;
+    particleSystem->emitters[emitterIdx].liveCount += count;
+
+    for(int n = 0; n < count; n++){
+        int idx = particleSystem->count++;
+        particleSystem->posX[idx] = desc->pos.x + particle_random_range(-desc->spawnExtent.x, desc->spawnExtent.x);
+        particleSystem->posY[idx] = desc->pos.y + particle_random_range(-desc->spawnExtent.y, desc->spawnExtent.y);
+        particleSystem->velX[idx] = particle_random_range(desc->velMin.x, desc->velMax.x);
+        particleSystem->velY[idx] = particle_random_range(desc->velMin.y, desc->velMax.y);
+        particleSystem->gravity[idx] = desc->gravity;
+        particleSystem->life[idx] = desc->lifetime;
+        particleSystem->frame[idx] = 0.0f;
+        particleSystem->frameSpeed[idx] = desc->frameSpeed;
+        particleSystem->emitterIdx[idx] = (unsigned char)emitterIdx;
+    }
+}
+
+void emit_particles(int emitterIdx, Vec2 pos, int count){
+    SM_ASSERT_GUARD(emitterIdx >= 0 && emitterIdx < MAX_PARTICLE_EMITTERS, , "Invalid Particle Emitter: %d", emitterIdx);
+    particleSystem->emitters[emitterIdx].desc.pos = pos;
+    emit_particles(emitterIdx, count);
+}
+
+// False once every particle is gone and no emitter spawns on its own
+bool particles_active(){
+    if(particleSystem->count) return true;
+    for(int idx = 0; idx < MAX_PARTICLE_EMITTERS; idx++){
+        ParticleEmitter* emitter = &particleSystem->emitters[idx];
+        if(emitter->active && emitter->desc.rate > 0.0f) return true;
+    }
+    return false;
+}
+
+void integrate_particles(int first, int last, float dt){
+    for(int idx = first; idx < last; idx++){
+        particleSystem->velY[idx] += particleSystem->gravity[idx] * dt;
+        particleSystem->posX[idx] += particleSystem->velX[idx] * dt;
+        particleSystem->posY[idx] += particleSystem->velY[idx] * dt;
+        particleSystem->life[idx] -= dt;
+        particleSystem->frame[idx] += particleSystem->frameSpeed[idx] * dt;
+    }
+}
+
+void update_particles(float dt){
+    for(int idx = 0; idx < MAX_PARTICLE_EMITTERS; idx++){
+        ParticleEmitter* emitter = &particleSystem->emitters[idx];
+        if(!emitter->active || emitter->desc.rate <= 0.0f) continue;
+        emitter->spawnAccumulator += emitter->desc.rate * dt;
+        int spawnCount = (int)emitter->spawnAccumulator;
+        emitter->spawnAccumulator -= (float)spawnCount;
+        emit_particles(idx, spawnCount);
+    }
+
+    int count = particleSystem->count;
+    int idx = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    {
+        __m128 dtWide = _mm_set1_ps(dt);
+        for(; idx + 4 <= count; idx += 4){
+            __m128 velY = _mm_add_ps(_mm_loadu_ps(&particleSystem->velY[idx]),
+                                     _mm_mul_ps(_mm_loadu_ps(&particleSystem->gravity[idx]), dtWide));
+            __m128 posX = _mm_add_ps(_mm_loadu_ps(&particleSystem->posX[idx]),
+                                     _mm_mul_ps(_mm_loadu_ps(&particleSystem->velX[idx]), dtWide));
+            __m128 posY = _mm_add_ps(_mm_loadu_ps(&particleSystem->posY[idx]), _mm_mul_ps(velY, dtWide));
+            __m128 life = _mm_sub_ps(_mm_loadu_ps(&particleSystem->life[idx]), dtWide);
+            __m128 frame = _mm_add_ps(_mm_loadu_ps(&particleSystem->frame[idx]),
+                                      _mm_mul_ps(_mm_loadu_ps(&particleSystem->frameSpeed[idx]), dtWide));
+            _mm_storeu_ps(&particleSystem->velY[idx], velY);
+            _mm_storeu_ps(&particleSystem->posX[idx], posX);
+            _mm_storeu_ps(&particleSystem->posY[idx], posY);
+            _mm_storeu_ps(&particleSystem->life[idx], life);
+            _mm_storeu_ps(&particleSystem->frame[idx], frame);
+        }
+    }
+#endif
+    integrate_particles(idx, count, dt);
+
+    // Dead particles are replaced by the last live one, order does not matter for rendering
+    idx = 0;
+    while(idx < particleSystem->count){
+        if(particleSystem->life[idx] > 0.0f){
+            idx++;
+            continue;
+        }
+        particleSystem->emitters[particleSystem->emitterIdx[idx]].liveCount--;
+        int last = --particleSystem->count;
+        particleSystem->posX[idx] = particleSystem->posX[last];
+        particleSystem->posY[idx] = particleSystem->posY[last];
+        particleSystem->velX[idx] = particleSystem->velX[last];
+        particleSystem->velY[idx] = particleSystem->velY[last];
+        particleSystem->gravity[idx] = particleSystem->gravity[last];
+        particleSystem->life[idx] = particleSystem->life[last];
+        particleSystem->frame[idx] = particleSystem->frame[last];
+        particleSystem->frameSpeed[idx] = particleSystem->frameSpeed[last];
+        particleSystem->emitterIdx[idx] = particleSystem->emitterIdx[last];
+    }
+}
+
+// Writes one Transform per visible particle straight into a reserved span of the instance buffer
+void draw_particles(){
+    Sprite sprites[MAX_PARTICLE_EMITTERS];
+    int frameCounts[MAX_PARTICLE_EMITTERS];
+    for(int idx = 0; idx < MAX_PARTICLE_EMITTERS; idx++){
+        sprites[idx] = get_sprite(particleSystem->emitters[idx].desc.spriteID);
+        frameCounts[idx] = particleSystem->emitters[idx].desc.frameCount > 0 ? particleSystem->emitters[idx].desc.frameCount : 1;
+    }
+
+    ViewRect view = get_camera_view(renderData->gameCamera);
+    TransformSpan span = reserve_transforms(particleSystem->count);
+    Transform* transforms = span.elements;
+    int usedCount = 0;
+    for(int idx = 0; idx < span.count; idx++){
+        int emitterIdx = particleSystem->emitterIdx[idx];
+        Sprite sprite = sprites[emitterIdx];
+        int frame = (int)particleSystem->frame[idx] % frameCounts[emitterIdx];
+
+        Transform* transform = &transforms[usedCount];
+        transform->pos = {particleSystem->posX[idx] - sprite.spriteSize.x * 0.5f, particleSystem->posY[idx] - sprite.spriteSize.y * 0.5f};
+        transform->size = vec_2(sprite.spriteSize);
+        transform->atlasOffset = {sprite.atlasOffset.x + frame * sprite.spriteSize.x, sprite.atlasOffset.y};
+        transform->spriteSize = sprite.spriteSize;
+        transform->paletteIdx = renderData->currentPalette;
+        transform->atlasPage = sprite.atlasPage;
+        usedCount += is_visible(view, transform->pos, transform->size);
+    }
+    trim_transforms(span, usedCount);
+}
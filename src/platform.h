@@ -3,13 +3,27 @@
 static bool running = true;
 
 bool platform_create_window(int width, int height, char* title);
-void platform_update_window();
+// True when any window message arrived or the cursor moved since the last call
+bool platform_update_window();
+// Blocks until a window message arrives or the timeout runs out
+void platform_wait_for_events(long long timeoutNs);
 void* platform_load_gl_function(char* funName);
 void platform_swap_buffers();
+// 1 waits for vblank, 0 swaps right away, -1 waits unless the frame missed it (adaptive). False if the driver can not
+bool platform_set_swap_interval(int interval);
+
+// Monotonic high resolution clock, nanoseconds from an arbitrary start
+long long platform_get_time_ns();
+// Sleeps for about nanoseconds, waking up late by up to a scheduler tick
+void platform_sleep_ns(long long nanoseconds);
 
 
 void* platform_load_dynamic_library(char* dll);
 void* platform_load_dynamic_function(void* dll, char* funName);
 bool platform_free_dynamic_library(void* dll);
 
+// Read only mapping of a whole file, nullptr with size 0 if it does not exist or is empty
+void* platform_map_file(char* path, long long* size);
+void platform_unmap_file(void* data);
+
 void platform_fill_keycode_lookup_table();
\ No newline at end of file
@@ -2,9 +2,30 @@
 #include "engine_lib.h"
 #include "assets.h"
 
+#include <math.h>
+
 //#####################################################################################################################################
 //                                                  Renderer Constants
 //#####################################################################################################################################
+constexpr int MAX_TRANSFORMS = 1 << 19;
+
+// 3x5 glyphs for ' ' to '~' in the font slice of the atlas, 16 per row in 4x6 cells that double as the advance and line height
+constexpr IVec2 FONT_ATLAS_OFFSET = SPRITES[SPRITE_FONT].atlasOffset;
+constexpr int FONT_ATLAS_PAGE = SPRITES[SPRITE_FONT].atlasPage;
+constexpr IVec2 FONT_GLYPH_SIZE = {3, 5};
+constexpr IVec2 FONT_CELL_SIZE = {4, 6};
+constexpr int FONT_COLUMNS = 16;
+constexpr char FONT_FIRST_CHAR = ' ';
+constexpr char FONT_LAST_CHAR = '~';
+
+constexpr int MAX_TEXT_LAYOUTS = 1024;                  // power of two, the table is flushed once it is 3/4 full
+constexpr int MAX_TEXT_LAYOUT_GLYPHS = 1 << 16;
+
+constexpr int TILEMAP_SIZE = 256;                       // tiles per side of the tile index texture, power of two
+constexpr int TILEMAP_REGION_SIZE = 32;                 // tiles per side of a region the game tracks and uploads
+constexpr int TILEMAP_REGIONS = TILEMAP_SIZE / TILEMAP_REGION_SIZE;
+constexpr int MAX_TILEMAP_TILES = 21;                   // distinct tiles of a tileset, index 0 is an empty tile
+constexpr int MAX_TILEMAP_UPLOADS = 256;                // per frame, regions that do not fit wait for the next one
 
 //#####################################################################################################################################
 //                                                  Renderer Structs
@@ -13,6 +34,7 @@ struct OrthographicCamera2D{
     float zoom = 1.0f;
     Vec2 dimensions;
     Vec2 position;
+    bool snapToPixel;           // round the position to whole world pixels, keeps sprites from swimming while scrolling
 };
 
 struct Transform {
@@ -20,12 +42,105 @@ struct Transform {
     Vec2 size;
     IVec2 atlasOffset;
     IVec2 spriteSize;
+    int paletteIdx;             // row of the palette texture, see PaletteID
+    int atlasPage;              // layer of the atlas texture, see ATLAS_PAGES
+};
+
+// Passes are drawn in this order, each on top of the ones before it
+enum RenderPassID{
+    RENDER_PASS_WORLD,
+    RENDER_PASS_UI,
+    RENDER_PASS_DEBUG,      // world space overlays drawn above the UI
+
+    RENDER_PASS_COUNT
+};
+
+// Instances of a pass are one contiguous range of RenderData::transforms
+struct RenderPass{
+    int instanceOffset;
+    int instanceCount;
+};
+
+struct CameraBounds{
+    float left, right, top, bottom;
+};
+
+struct ViewRect{
+    Vec2 min;
+    Vec2 max;
+};
+
+// Tiles in [min, max), already clamped to the grid they were requested for
+struct TileRange{
+    IVec2 min;
+    IVec2 max;
+};
+
+// Window rect the native render target is scaled into, in window pixels from the top left
+struct UpscaleViewport{
+    IVec2 pos;
+    IVec2 size;
+};
+
+struct TransformSpan{
+    Transform* elements;
+    int count;
+};
+
+// Glyph quads of one string, relative to its top left with the scale already applied
+struct TextLayout{
+    unsigned long long hash;    // 0 marks a free slot
+    int glyphOffset;            // into TextLayoutCache::glyphs
+    int glyphCount;
+};
+
+// Strings are looked up by hash, unchanged text is copied out instead of laid out again. When either table runs
+// out everything is flushed, text drawn every frame is back in the cache right away.
+struct TextLayoutCache{
+    int layoutCount;
+    int glyphCount;
+    TextLayout layouts[MAX_TEXT_LAYOUTS];
+    Transform glyphs[MAX_TEXT_LAYOUT_GLYPHS];
+};
+
+// Tile indices row after row at dataOffset in Tilemap::uploadData
+struct TilemapUpload{
+    IVec2 pos;                  // in tiles, never crosses a region border
+    IVec2 size;
+    int dataOffset;
+};
+
+// The tile layer as an index texture that wraps every TILEMAP_SIZE tiles, the renderers draw it at the start of the
+// world pass with one screen covering triangle. The game keeps the regions under the camera uploaded, edits only
+// upload the tiles that changed
+struct Tilemap{
+    IVec2 sizeInTiles;          // nothing is drawn outside [0, sizeInTiles), 0 turns the layer off
+    int tileSize;
+    PaletteID palette;
+    int atlasPage;
+    IVec2 atlasOffsets[MAX_TILEMAP_TILES];  // of tile index + 1
+
+    // What the texture holds, regions are indexed by their coordinate modulo TILEMAP_REGIONS. Only the game reads these
+    IVec2 regionCoords[TILEMAP_REGIONS * TILEMAP_REGIONS];
+    bool regionLoaded[TILEMAP_REGIONS * TILEMAP_REGIONS];
+
+    // Consumed by the next renderer that runs, see clear_tilemap_uploads
+    Array<TilemapUpload, MAX_TILEMAP_UPLOADS> uploads;
+    int uploadDataSize;
+    unsigned char uploadData[TILEMAP_SIZE * TILEMAP_SIZE];
 };
 
 struct RenderData{
     OrthographicCamera2D gameCamera;
+    Vec2 prevGameCameraPos;     // where gameCamera was last frame, outside GameState so rewinding leaves it alone
     OrthographicCamera2D uiCamera;
-    Array<Transform, 1000> transforms;
+    RenderPassID currentPass;
+    PaletteID currentPalette;   // what the draw functions below put into Transform::paletteIdx
+    int passOffsets[RENDER_PASS_COUNT];
+    Array<Transform, MAX_TRANSFORMS> transforms;
+    TextLayoutCache textCache;
+    Tilemap tilemap;
+    bool idle;                  // set by the game, the next frame looks the same as this one unless new input arrives
 };
 
 //#####################################################################################################################################
@@ -36,18 +151,151 @@ static RenderData* renderData;
 //#####################################################################################################################################
 //                                                  Renderer Utility
 //#####################################################################################################################################
+// The values gl_render feeds to orthographic_projection
+CameraBounds get_camera_bounds(OrthographicCamera2D camera){
+    if(camera.snapToPixel) camera.position = {floorf(camera.position.x + 0.5f), floorf(camera.position.y + 0.5f)};
+    CameraBounds bounds = {};
+    bounds.left = camera.position.x - camera.dimensions.x / 2.0f;
+    bounds.right = camera.position.x + camera.dimensions.x / 2.0f;
+    bounds.top = camera.position.y - camera.dimensions.y / 2.0f;
+    bounds.bottom = camera.position.y + camera.dimensions.y / 2.0f;
+    return bounds;
+}
+
+// World area that ends up on screen, orthographic_projection negates the y translation so the visible
+// rows are [-bottom, -top] instead of [top, bottom]
+ViewRect get_camera_view(OrthographicCamera2D camera){
+    CameraBounds bounds = get_camera_bounds(camera);
+    return {{bounds.left, -bounds.bottom}, {bounds.right, -bounds.top}};
+}
+
+bool is_visible(ViewRect view, Vec2 pos, Vec2 size){
+    return pos.x < view.max.x && pos.x + size.x > view.min.x &&
+           pos.y < view.max.y && pos.y + size.y > view.min.y;
+}
+
+// One target pixel per world unit, the camera always renders at its native resolution
+IVec2 get_native_resolution(OrthographicCamera2D camera){
+    return {max((int)ceilf(camera.dimensions.x), 1), max((int)ceilf(camera.dimensions.y), 1)};
+}
+
+// Largest whole multiple of the native resolution that fits the window, centered with black bars around it.
+// Windows smaller than the native resolution fall back to a fractional fit that keeps the aspect ratio.
+UpscaleViewport get_upscale_viewport(IVec2 screenSize, IVec2 nativeSize){
+    screenSize = {max(screenSize.x, 1), max(screenSize.y, 1)};
+    int scale = min(screenSize.x / nativeSize.x, screenSize.y / nativeSize.y);
+    UpscaleViewport viewport = {};
+    if(scale >= 1){
+        viewport.size = {nativeSize.x * scale, nativeSize.y * scale};
+    } else {
+        float fit = min((float)screenSize.x / nativeSize.x, (float)screenSize.y / nativeSize.y);
+        viewport.size = {max((int)(nativeSize.x * fit), 1), max((int)(nativeSize.y * fit), 1)};
+    }
+    viewport.pos = {(screenSize.x - viewport.size.x) / 2, (screenSize.y - viewport.size.y) / 2};
+    return viewport;
+}
+
 IVec2 screen_to_world(IVec2 screenPos){
-    OrthographicCamera2D camera = renderData->gameCamera;
-    int xPos = (float)screenPos.x / (float)input->screenSize.x * camera.dimensions.x;
-    xPos += -camera.dimensions.x / 2.0f + camera.position.x;
-    int yPos = (float)screenPos.y / (float)input->screenSize.y * camera.dimensions.y;
-    yPos += camera.dimensions.y / 2.0f + camera.position.y;
+    ViewRect view = get_camera_view(renderData->gameCamera);
+    UpscaleViewport viewport = get_upscale_viewport(input->screenSize, get_native_resolution(renderData->gameCamera));
+    IVec2 localPos = screenPos - viewport.pos;
+    int xPos = (int)floorf(view.min.x + (float)localPos.x / (float)viewport.size.x * (view.max.x - view.min.x));
+    int yPos = (int)floorf(view.min.y + (float)localPos.y / (float)viewport.size.y * (view.max.y - view.min.y));
     return {xPos, yPos};
 }
+
+TileRange get_visible_tile_range(OrthographicCamera2D camera, int tileSize, IVec2 gridSize){
+    ViewRect view = get_camera_view(camera);
+    TileRange range = {};
+    range.min = {(int)floorf(view.min.x / tileSize), (int)floorf(view.min.y / tileSize)};
+    range.max = {(int)ceilf(view.max.x / tileSize), (int)ceilf(view.max.y / tileSize)};
+    if(range.min.x < 0) range.min.x = 0;
+    if(range.min.y < 0) range.min.y = 0;
+    if(range.max.x > gridSize.x) range.max.x = gridSize.x;
+    if(range.max.y > gridSize.y) range.max.y = gridSize.y;
+    return range;
+}
+
+OrthographicCamera2D get_pass_camera(int passID){
+    return passID == RENDER_PASS_UI ? renderData->uiCamera : renderData->gameCamera;
+}
+
+// Passes that were never begun this frame come back empty
+RenderPass get_render_pass(int passID){
+    RenderPass pass = {};
+    if(passID > renderData->currentPass) return {renderData->transforms.count, 0};
+    int end = passID < renderData->currentPass ? renderData->passOffsets[passID + 1] : renderData->transforms.count;
+    pass.instanceOffset = renderData->passOffsets[passID];
+    pass.instanceCount = end - pass.instanceOffset;
+    return pass;
+}
+
 //#####################################################################################################################################
 //                                                  Renderer Functions
 //#####################################################################################################################################
-void draw_quad(Transform transform){ renderData->transforms.add(transform);}
+// Everything drawn from here on goes into passID, passes have to be begun in RenderPassID order each frame
+void begin_render_pass(RenderPassID passID){
+    SM_ASSERT_GUARD(passID >= renderData->currentPass, , "Render pass %d begun after pass %d", passID, renderData->currentPass);
+    for(int idx = renderData->currentPass + 1; idx <= passID; idx++){
+        renderData->passOffsets[idx] = renderData->transforms.count;
+    }
+    renderData->currentPass = passID;
+}
+
+// Applies to everything drawn afterwards until the end of the frame
+void set_palette(PaletteID paletteID){
+    renderData->currentPalette = paletteID;
+}
+
+// Called by the renderers once the frame is submitted
+void clear_render_passes(){
+    renderData->transforms.clear();
+    renderData->currentPass = RENDER_PASS_WORLD;
+    renderData->currentPalette = PALETTE_DEFAULT;
+    renderData->passOffsets[RENDER_PASS_WORLD] = 0;
+}
+
+// Tile indices of size.x * size.y tiles at pos for the renderer to fill in, nullptr once this frame's uploads are full
+unsigned char* reserve_tilemap_upload(IVec2 pos, IVec2 size){
+    Tilemap* tilemap = &renderData->tilemap;
+    int dataSize = size.x * size.y;
+    if(tilemap->uploads.is_full() || tilemap->uploadDataSize + dataSize > (int)sizeof(tilemap->uploadData)) return nullptr;
+    tilemap->uploads.add({pos, size, tilemap->uploadDataSize});
+    unsigned char* result = tilemap->uploadData + tilemap->uploadDataSize;
+    tilemap->uploadDataSize += dataSize;
+    return result;
+}
+
+// Called by the renderers once the uploads are in their copy of the tilemap, unlike the passes they are kept
+// around for frames that are not rendered
+void clear_tilemap_uploads(){
+    renderData->tilemap.uploads.clear();
+    renderData->tilemap.uploadDataSize = 0;
+}
+
+// Reserves count instance slots in one go, the span is shorter than requested only when the instance buffer is full
+TransformSpan reserve_transforms(int count){
+    int available = renderData->transforms.maxElements - renderData->transforms.count;
+    if(count > available){
+        SM_WARN("Instance buffer is full, dropping %d instances", count - available);
+        count = available;
+    }
+    return {renderData->transforms.push(count), count};
+}
+
+// Gives back the unused tail of the most recent reservation
+void trim_transforms(TransformSpan span, int usedCount){
+    SM_ASSERT_GUARD(span.elements + span.count == renderData->transforms.elements + renderData->transforms.count, ,
+                    "Only the most recent reservation can be trimmed");
+    SM_ASSERT_GUARD(usedCount >= 0 && usedCount <= span.count, , "Used count %d is outside the span", usedCount);
+    renderData->transforms.count -= span.count - usedCount;
+}
+
+// Quads outside the camera of the current pass never reach the instance buffer
+void draw_quad(const Transform& transform){
+    if(!is_visible(get_camera_view(get_pass_camera(renderData->currentPass)), transform.pos, transform.size)) return;
+    renderData->transforms.add(transform);
+}
 
 void draw_quad(Vec2 pos, Vec2 size){
     Transform transform = {};
@@ -55,20 +303,146 @@ void draw_quad(Vec2 pos, Vec2 size){
     transform.size = size;
     transform.atlasOffset = {0, 0};
     transform.spriteSize = {1, 1};
+    transform.paletteIdx = renderData->currentPalette;
     draw_quad(transform);
 }
 
-void draw_sprite(SpriteID spriteID, Vec2 pos){
-    Sprite sprite = get_sprite(spriteID);
+void draw_sprite(Sprite sprite, Vec2 pos){
     Transform transform = {};
     transform.size = vec_2(sprite.spriteSize);
     transform.pos = pos - vec_2(sprite.spriteSize) / 2.0f;
     transform.atlasOffset = sprite.atlasOffset;
     transform.spriteSize = sprite.spriteSize;
+    transform.paletteIdx = renderData->currentPalette;
+    transform.atlasPage = sprite.atlasPage;
     draw_quad(transform);
 }
 
+void draw_sprite(SpriteID spriteID, Vec2 pos){
+    draw_sprite(get_sprite(spriteID), pos);
+}
+
 void draw_sprite(SpriteID spriteID, IVec2 pos){
-    draw_sprite(spriteID, vec_2(pos));
+    draw_sprite(get_sprite(spriteID), vec_2(pos));
+}
+
+void draw_sprite(PackedSpriteID spriteID, Vec2 pos){
+    draw_sprite(get_sprite(spriteID), pos);
+}
+
+// Same placement as draw_sprite, one sprite centered on each position
+void draw_sprites(SpriteID spriteID, const IVec2* positions, int count){
+    Sprite sprite = get_sprite(spriteID);
+    Vec2 size = vec_2(sprite.spriteSize);
+    Vec2 halfSize = size / 2.0f;
+
+    ViewRect view = get_camera_view(get_pass_camera(renderData->currentPass));
+    TransformSpan span = reserve_transforms(count);
+    Transform* transforms = span.elements;
+    int usedCount = 0;
+    for(int idx = 0; idx < span.count; idx++){
+        Vec2 pos = {(float)positions[idx].x - halfSize.x, (float)positions[idx].y - halfSize.y};
+        // Always write, only advance for visible sprites, keeps the loop free of branches
+        transforms[usedCount].pos = pos;
+        transforms[usedCount].size = size;
+        transforms[usedCount].atlasOffset = sprite.atlasOffset;
+        transforms[usedCount].spriteSize = sprite.spriteSize;
+        transforms[usedCount].paletteIdx = renderData->currentPalette;
+        transforms[usedCount].atlasPage = sprite.atlasPage;
+        usedCount += is_visible(view, pos, size);
+    }
+    trim_transforms(span, usedCount);
+}
+
+//#####################################################################################################################################
+//                                                  Text Rendering
+//#####################################################################################################################################
+// FNV-1a over the characters and the scale, length is the number of characters
+unsigned long long hash_text(char* text, float scale, int* length){
+    unsigned long long hash = 14695981039346656037ull;
+    char* cursor = text;
+    for(; *cursor; cursor++){
+        hash = (hash ^ (unsigned char)*cursor) * 1099511628211ull;
+    }
+    unsigned int scaleBits;
+    memcpy(&scaleBits, &scale, sizeof(scaleBits));
+    hash = (hash ^ scaleBits) * 1099511628211ull;
+    *length = (int)(cursor - text);
+    return hash ? hash : 1;
 }
 
+// Slot holding hash, or the free slot it would go into
+TextLayout* find_text_layout_slot(TextLayoutCache* cache, unsigned long long hash){
+    int slot = (int)(hash & (MAX_TEXT_LAYOUTS - 1));
+    while(cache->layouts[slot].hash && cache->layouts[slot].hash != hash){
+        slot = (slot + 1) & (MAX_TEXT_LAYOUTS - 1);
+    }
+    return &cache->layouts[slot];
+}
+
+void clear_text_layouts(TextLayoutCache* cache){
+    memset(cache->layouts, 0, sizeof(cache->layouts));
+    cache->layoutCount = 0;
+    cache->glyphCount = 0;
+}
+
+// Spaces and newlines only move the pen, characters outside the font show up as '?'
+TextLayout* get_text_layout(char* text, float scale){
+    TextLayoutCache* cache = &renderData->textCache;
+    int length = 0;
+    unsigned long long hash = hash_text(text, scale, &length);
+    TextLayout* layout = find_text_layout_slot(cache, hash);
+    if(layout->hash) return layout;
+
+    SM_ASSERT_GUARD(length <= MAX_TEXT_LAYOUT_GLYPHS, nullptr, "Text of %d characters does not fit the layout cache", length);
+    if(cache->glyphCount + length > MAX_TEXT_LAYOUT_GLYPHS || cache->layoutCount >= MAX_TEXT_LAYOUTS * 3 / 4){
+        clear_text_layouts(cache);
+        layout = find_text_layout_slot(cache, hash);
+    }
+
+    layout->hash = hash;
+    layout->glyphOffset = cache->glyphCount;
+    Vec2 pen = {};
+    Vec2 size = {FONT_GLYPH_SIZE.x * scale, FONT_GLYPH_SIZE.y * scale};
+    for(char* cursor = text; *cursor; cursor++){
+        char c = *cursor;
+        if(c == '\n'){
+            pen = {0.0f, pen.y + FONT_CELL_SIZE.y * scale};
+            continue;
+        }
+        if(c != ' '){
+            if(c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) c = '?';
+            int glyph = c - FONT_FIRST_CHAR;
+            Transform* transform = &cache->glyphs[cache->glyphCount++];
+            transform->pos = pen;
+            transform->size = size;
+            transform->atlasOffset = {FONT_ATLAS_OFFSET.x + (glyph % FONT_COLUMNS) * FONT_CELL_SIZE.x,
+                                      FONT_ATLAS_OFFSET.y + (glyph / FONT_COLUMNS) * FONT_CELL_SIZE.y};
+            transform->spriteSize = FONT_GLYPH_SIZE;
+            transform->atlasPage = FONT_ATLAS_PAGE;
+        }
+        pen.x += FONT_CELL_SIZE.x * scale;
+    }
+    layout->glyphCount = cache->glyphCount - layout->glyphOffset;
+    cache->layoutCount++;
+    return layout;
+}
+
+// pos is the top left of the first line, glyphs go into the current pass like any other quad
+void draw_text(char* text, Vec2 pos, float scale = 1.0f){
+    TextLayout* layout = get_text_layout(text, scale);
+    if(!layout) return;
+
+    Transform* glyphs = &renderData->textCache.glyphs[layout->glyphOffset];
+    ViewRect view = get_camera_view(get_pass_camera(renderData->currentPass));
+    TransformSpan span = reserve_transforms(layout->glyphCount);
+    int usedCount = 0;
+    for(int idx = 0; idx < span.count; idx++){
+        Transform* transform = &span.elements[usedCount];
+        *transform = glyphs[idx];
+        transform->pos = {glyphs[idx].pos.x + pos.x, glyphs[idx].pos.y + pos.y};
+        transform->paletteIdx = renderData->currentPalette;
+        usedCount += is_visible(view, transform->pos, transform->size);
+    }
+    trim_transforms(span, usedCount);
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "engine_lib.h"
+#include "platform.h"
+#include "render_interface.h"
+
+//#####################################################################################################################################
+//                                                  Render Metrics Constants
+//#####################################################################################################################################
+constexpr int METRICS_HISTORY = 256;
+constexpr int METRICS_FLUSH_INTERVAL = 60;      // frames, a soak run that crashes loses at most this many
+constexpr int METRICS_GRAPH_FRAMES = 120;
+constexpr float METRICS_GRAPH_HEIGHT = 40.0f;   // UI pixels, a frame at twice FRAME_TIME reaches the top
+
+//#####################################################################################################################################
+//                                                  Render Metrics Structs
+//#####################################################################################################################################
+// Consecutive parts of one iteration of the main loop, they add up to the wall time between two presented frames
+enum FramePhase{
+    FRAME_PHASE_RELOAD,     // game.dll hot reload check
+    FRAME_PHASE_PACING,     // frame limiter sleep and spin
+    FRAME_PHASE_INPUT,
+    FRAME_PHASE_UPDATE,
+    FRAME_PHASE_RENDER,
+    FRAME_PHASE_PRESENT,    // swap and the fence wait behind it
+    FRAME_PHASE_IDLE,       // waiting for events while idle frames are skipped
+    FRAME_PHASE_COUNT
+};
+
+static const char* FRAME_PHASE_NAMES[FRAME_PHASE_COUNT] = {"reload", "pacing", "input", "update", "render", "present", "idle"};
+
+struct FrameMetrics{
+    int frame;
+    float frameMs;
+    float phaseMs[FRAME_PHASE_COUNT];
+    int passInstances[RENDER_PASS_COUNT];
+    int drawCalls;
+    long long uploadBytes;          // buffer and texture data handed to GL
+    int shaderReloads, textureReloads;
+    long long transientBytes, persistentBytes;
+};
+
+struct RenderMetrics{
+    FrameMetrics current;
+    FramePhase phase;
+    long long phaseStartNs;
+
+    // Indexed by frame % METRICS_HISTORY
+    FrameMetrics history[METRICS_HISTORY];
+    int frameCount;
+
+    FILE* file;
+    bool jsonLines;
+    bool showGraph;
+};
+
+//#####################################################################################################################################
+//                                                  Render Metrics Globals
+//#####################################################################################################################################
+static RenderMetrics renderMetrics;
+
+//#####################################################################################################################################
+//                                                  Render Metrics Functions
+//#####################################################################################################################################
+// Every presented frame is written as one line, *.jsonl gets JSON lines and anything else CSV
+bool open_metrics_file(char* path){
+    renderMetrics.file = fopen(path, "wb");
+    SM_ASSERT_GUARD(renderMetrics.file, false, "Failed to open Metrics file: %s", path);
+    int length = (int)strlen(path);
+    renderMetrics.jsonLines = length > 6 && strcmp(path + length - 6, ".jsonl") == 0;
+    if(!renderMetrics.jsonLines){
+        fprintf(renderMetrics.file, "frame,frame_ms");
+        for(int phase = 0; phase < FRAME_PHASE_COUNT; phase++) fprintf(renderMetrics.file, ",%s_ms", FRAME_PHASE_NAMES[phase]);
+        fprintf(renderMetrics.file, ",world_instances,ui_instances,debug_instances,draw_calls,upload_bytes,"
+                                    "shader_reloads,texture_reloads,transient_bytes,persistent_bytes\n");
+    }
+    SM_TRACE("Writing Metrics to %s", path);
+    return true;
+}
+
+void close_metrics_file(){
+    if(!renderMetrics.file) return;
+    fclose(renderMetrics.file);
+    renderMetrics.file = nullptr;
+}
+
+// Ends the running phase, time spent in a phase more than once per frame adds up
+void begin_metrics_phase(FramePhase phase){
+    long long now = platform_get_time_ns();
+    if(renderMetrics.phaseStartNs) renderMetrics.current.phaseMs[renderMetrics.phase] += (now - renderMetrics.phaseStartNs) / 1000000.0f;
+    renderMetrics.phase = phase;
+    renderMetrics.phaseStartNs = now;
+}
+
+void write_frame_metrics(FrameMetrics* metrics){
+    FILE* file = renderMetrics.file;
+    if(renderMetrics.jsonLines){
+        fprintf(file, "{\"frame\":%d,\"frame_ms\":%.3f", metrics->frame, metrics->frameMs);
+        for(int phase = 0; phase < FRAME_PHASE_COUNT; phase++) fprintf(file, ",\"%s_ms\":%.3f", FRAME_PHASE_NAMES[phase], metrics->phaseMs[phase]);
+        fprintf(file, ",\"world_instances\":%d,\"ui_instances\":%d,\"debug_instances\":%d,\"draw_calls\":%d,\"upload_bytes\":%lld,"
+                      "\"shader_reloads\":%d,\"texture_reloads\":%d,\"transient_bytes\":%lld,\"persistent_bytes\":%lld}\n",
+                metrics->passInstances[RENDER_PASS_WORLD], metrics->passInstances[RENDER_PASS_UI], metrics->passInstances[RENDER_PASS_DEBUG],
+                metrics->drawCalls, metrics->uploadBytes, metrics->shaderReloads, metrics->textureReloads,
+                metrics->transientBytes, metrics->persistentBytes);
+    } else {
+        fprintf(file, "%d,%.3f", metrics->frame, metrics->frameMs);
+        for(int phase = 0; phase < FRAME_PHASE_COUNT; phase++) fprintf(file, ",%.3f", metrics->phaseMs[phase]);
+        fprintf(file, ",%d,%d,%d,%d,%lld,%d,%d,%lld,%lld\n",
+                metrics->passInstances[RENDER_PASS_WORLD], metrics->passInstances[RENDER_PASS_UI], metrics->passInstances[RENDER_PASS_DEBUG],
+                metrics->drawCalls, metrics->uploadBytes, metrics->shaderReloads, metrics->textureReloads,
+                metrics->transientBytes, metrics->persistentBytes);
+    }
+    if(metrics->frame % METRICS_FLUSH_INTERVAL == 0) fflush(file);
+}
+
+// Right before the transient arena is reset, closes the record of the frame that was just presented
+void end_metrics_frame(BumpAllocator* transientStorage, BumpAllocator* persistentStorage){
+    begin_metrics_phase(FRAME_PHASE_RELOAD);
+    FrameMetrics* metrics = &renderMetrics.current;
+    metrics->frame = renderMetrics.frameCount;
+    metrics->frameMs = 0.0f;
+    for(int phase = 0; phase < FRAME_PHASE_COUNT; phase++) metrics->frameMs += metrics->phaseMs[phase];
+    metrics->transientBytes = (long long)transientStorage->used;
+    metrics->persistentBytes = (long long)persistentStorage->used;
+
+    renderMetrics.history[renderMetrics.frameCount % METRICS_HISTORY] = *metrics;
+    if(renderMetrics.file) write_frame_metrics(metrics);
+    renderMetrics.frameCount++;
+    *metrics = {};
+}
+
+// Frame times of the last METRICS_GRAPH_FRAMES frames as bars along the bottom of the UI, newest on the right,
+// with a marker at FRAME_TIME. Has to run before the renderer takes the frame
+void draw_metrics_graph(float frameBudgetMs){
+    if(!renderMetrics.showGraph) return;
+    begin_render_pass(RENDER_PASS_UI);
+    float bottom = renderData->uiCamera.dimensions.y;
+    float scale = METRICS_GRAPH_HEIGHT / (frameBudgetMs * 2.0f);
+    draw_quad({METRICS_GRAPH_FRAMES / 2.0f, bottom - frameBudgetMs * scale}, {(float)METRICS_GRAPH_FRAMES, 0.5f});
+
+    int frameCount = min(renderMetrics.frameCount, METRICS_GRAPH_FRAMES);
+    for(int idx = 0; idx < frameCount; idx++){
+        FrameMetrics* metrics = &renderMetrics.history[(renderMetrics.frameCount - frameCount + idx) % METRICS_HISTORY];
+        float height = min(metrics->frameMs * scale, METRICS_GRAPH_HEIGHT);
+        float x = (float)(METRICS_GRAPH_FRAMES - frameCount + idx);
+        draw_quad({x + 0.5f, bottom - height / 2.0f}, {1.0f, height});
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include "engine_lib.h"
+#include "level.h"
+
+//#####################################################################################################################################
+//                                                  Rewind Structs
+//#####################################################################################################################################
+struct RewindFrame{
+    int offset;                 // into RewindBuffer::data
+    int size;
+    bool isKeyframe;
+};
+
+// Ring buffer of state snapshots. Keyframes are stored whole, every other frame as the XOR against the last keyframe,
+// both PackBits compressed (see level.h). Records are written contiguously into `data`, the oldest frames are dropped
+// when room is needed, together with the deltas that depended on a dropped keyframe. Everything is allocated up front,
+// so the memory footprint never grows.
+struct RewindBuffer{
+    int snapshotSize;
+    int maxPackedSize;
+    int frameCapacity;
+    int keyframeInterval;
+    int dataSize;
+
+    long long nextFrame;        // absolute number of the next captured frame
+    int frameCount;             // live frames are [nextFrame - frameCount, nextFrame)
+    long long keyframeFrame;    // frame `keyframe` was taken from, -1 forces a new keyframe
+    int head;                   // end of the newest record in `data`
+
+    RewindFrame* frames;        // frameCapacity entries, frame n lives in frames[n % frameCapacity]
+    char* keyframe;             // raw copy of the newest keyframe, deltas are taken against it
+    char* scratch;
+    char* data;
+};
+
+//#####################################################################################################################################
+//                                                  Rewind Globals
+//#####################################################################################################################################
+static RewindBuffer* rewindBuffer;
+
+//#####################################################################################################################################
+//                                                  Rewind Utility
+//#####################################################################################################################################
+RewindFrame* get_rewind_frame(RewindBuffer* buffer, long long frame){ return &buffer->frames[frame % buffer->frameCapacity]; }
+
+long long get_oldest_rewind_frame(RewindBuffer* buffer){ return buffer->nextFrame - buffer->frameCount; }
+
+// Drops the oldest frame and every delta after it that has no keyframe left to be applied to
+void drop_oldest_rewind_frame(RewindBuffer* buffer){
+    buffer->frameCount--;
+    while(buffer->frameCount > 0 && !get_rewind_frame(buffer, get_oldest_rewind_frame(buffer))->isKeyframe){
+        buffer->frameCount--;
+    }
+    if(buffer->frameCount == 0) buffer->head = 0;
+}
+
+// Returns where a record of maxPackedSize bytes can be written, dropping old frames until it fits
+int reserve_rewind_record(RewindBuffer* buffer){
+    if(buffer->frameCount == buffer->frameCapacity) drop_oldest_rewind_frame(buffer);
+    while(buffer->frameCount > 0){
+        int tail = get_rewind_frame(buffer, get_oldest_rewind_frame(buffer))->offset;
+        if(tail < buffer->head){
+            // Live records are [tail, head), free space is after head and in front of tail
+            if(buffer->head + buffer->maxPackedSize <= buffer->dataSize) return buffer->head;
+            if(buffer->maxPackedSize <= tail) return 0;
+        } else if(buffer->head + buffer->maxPackedSize <= tail){
+            // Live records wrap around the end, free space is between head and tail
+            return buffer->head;
+        }
+        drop_oldest_rewind_frame(buffer);
+    }
+    return 0;
+}
+
+//#####################################################################################################################################
+//                                                  Rewind Functions
+//#####################################################################################################################################
+// dataSize has to hold at least a single keyframe, roughly snapshotSize plus 1%
+RewindBuffer make_rewind_buffer(BumpAllocator* bumpAllocator, int snapshotSize, int frameCapacity, int keyframeInterval, int dataSize){
+    RewindBuffer buffer = {};
+    buffer.snapshotSize = snapshotSize;
+    buffer.maxPackedSize = snapshotSize + snapshotSize / 128 + 1;
+    buffer.frameCapacity = frameCapacity;
+    buffer.keyframeInterval = keyframeInterval;
+    buffer.dataSize = dataSize;
+    buffer.keyframeFrame = -1;
+    SM_ASSERT(frameCapacity > 0 && keyframeInterval > 0, "Rewind Buffer needs room for frames");
+    SM_ASSERT(dataSize >= buffer.maxPackedSize, "Rewind Buffer data of %d bytes can not hold a %d byte keyframe", dataSize, buffer.maxPackedSize);
+
+    buffer.frames = (RewindFrame*)bump_alloc(bumpAllocator, sizeof(RewindFrame) * frameCapacity);
+    buffer.keyframe = bump_alloc(bumpAllocator, snapshotSize);
+    buffer.scratch = bump_alloc(bumpAllocator, snapshotSize);
+    buffer.data = bump_alloc(bumpAllocator, dataSize);
+    return buffer;
+}
+
+// Forgets every frame, the memory stays with the buffer
+void clear_rewind_buffer(RewindBuffer* buffer){
+    buffer->nextFrame = 0;
+    buffer->frameCount = 0;
+    buffer->keyframeFrame = -1;
+    buffer->head = 0;
+}
+
+int get_rewind_memory_size(RewindBuffer* buffer){
+    return sizeof(RewindBuffer) + sizeof(RewindFrame) * buffer->frameCapacity + 2 * buffer->snapshotSize + buffer->dataSize;
+}
+
+void rewind_capture(RewindBuffer* buffer, void* state){
+    int offset = reserve_rewind_record(buffer);
+
+    // A keyframe is needed on the interval and whenever the last one was dropped or stepped back over
+    bool isKeyframe = buffer->keyframeFrame < get_oldest_rewind_frame(buffer) ||
+                      buffer->nextFrame - buffer->keyframeFrame >= buffer->keyframeInterval;
+    unsigned char* source = (unsigned char*)state;
+    if(isKeyframe){
+        memcpy(buffer->keyframe, state, buffer->snapshotSize);
+        buffer->keyframeFrame = buffer->nextFrame;
+    } else {
+        for(int idx = 0; idx < buffer->snapshotSize; idx++){
+            buffer->scratch[idx] = buffer->keyframe[idx] ^ source[idx];
+        }
+        source = (unsigned char*)buffer->scratch;
+    }
+
+    RewindFrame* frame = get_rewind_frame(buffer, buffer->nextFrame);
+    frame->offset = offset;
+    frame->size = pack_bits(source, buffer->snapshotSize, (unsigned char*)buffer->data + offset);
+    frame->isKeyframe = isKeyframe;
+    buffer->head = offset + frame->size;
+    buffer->nextFrame++;
+    buffer->frameCount++;
+}
+
+// framesAgo 0 is the newest frame, at most one keyframe and one delta are unpacked
+bool rewind_restore(RewindBuffer* buffer, int framesAgo, void* state){
+    if(framesAgo < 0 || framesAgo >= buffer->frameCount) return false;
+    long long target = buffer->nextFrame - 1 - framesAgo;
+    long long keyframe = target;
+    while(!get_rewind_frame(buffer, keyframe)->isKeyframe) keyframe--;
+
+    RewindFrame* frame = get_rewind_frame(buffer, keyframe);
+    bool result = unpack_bits((unsigned char*)buffer->data + frame->offset, frame->size, (unsigned char*)state, buffer->snapshotSize);
+    if(keyframe == target || !result) return result;
+
+    frame = get_rewind_frame(buffer, target);
+    result = unpack_bits((unsigned char*)buffer->data + frame->offset, frame->size, (unsigned char*)buffer->scratch, buffer->snapshotSize);
+    unsigned char* bytes = (unsigned char*)state;
+    for(int idx = 0; idx < buffer->snapshotSize; idx++){
+        bytes[idx] ^= buffer->scratch[idx];
+    }
+    return result;
+}
+
+// Drops the newest frame and restores the one before it, capturing afterwards continues from there
+bool rewind_step_back(RewindBuffer* buffer, void* state){
+    if(buffer->frameCount < 2) return false;
+    buffer->nextFrame--;
+    buffer->frameCount--;
+    RewindFrame* dropped = get_rewind_frame(buffer, buffer->nextFrame);
+    buffer->head = dropped->offset;
+    if(dropped->isKeyframe) buffer->keyframeFrame = -1;
+    return rewind_restore(buffer, 0, state);
+}
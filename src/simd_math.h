@@ -0,0 +1,109 @@
+#pragma once
+#include "engine_lib.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+//#####################################################################################################################################
+//                                                  SIMD Math Utility
+//#####################################################################################################################################
+// Runtime halves of the operators below. The operators stay constexpr by taking the scalar path while the compiler
+// evaluates them, every other call ends up here
+#if defined(__SSE2__) || defined(_M_X64)
+__m128 simd_load(Vec4 v){ return _mm_loadu_ps(v.values); }
+
+Vec4 simd_store(__m128 v){
+    Vec4 result;
+    _mm_storeu_ps(result.values, v);
+    return result;
+}
+
+// Columns scaled by the components of v and summed
+__m128 simd_mul(Mat4 m, __m128 v){
+    __m128 result = _mm_mul_ps(simd_load(m.values[0]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    result = _mm_add_ps(result, _mm_mul_ps(simd_load(m.values[1]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    result = _mm_add_ps(result, _mm_mul_ps(simd_load(m.values[2]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    result = _mm_add_ps(result, _mm_mul_ps(simd_load(m.values[3]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    return result;
+}
+
+Mat4 simd_mul(Mat4 a, Mat4 b){
+    Mat4 result;
+    for(int column = 0; column < 4; column++) result.values[column] = simd_store(simd_mul(a, simd_load(b.values[column])));
+    return result;
+}
+
+float simd_dot(Vec4 a, Vec4 b){
+    __m128 product = _mm_mul_ps(simd_load(a), simd_load(b));
+    __m128 sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+//#####################################################################################################################################
+//                                                  Vec4 and Mat4 Operators
+//#####################################################################################################################################
+// Mat4 is column major like GLSL, values[n] is column n
+constexpr Vec4 operator+(Vec4 a, Vec4 b){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_store(_mm_add_ps(simd_load(a), simd_load(b)));
+#endif
+    return {{a.values[0] + b.values[0], a.values[1] + b.values[1], a.values[2] + b.values[2], a.values[3] + b.values[3]}};
+}
+
+constexpr Vec4 operator-(Vec4 a, Vec4 b){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_store(_mm_sub_ps(simd_load(a), simd_load(b)));
+#endif
+    return {{a.values[0] - b.values[0], a.values[1] - b.values[1], a.values[2] - b.values[2], a.values[3] - b.values[3]}};
+}
+
+// Component wise
+constexpr Vec4 operator*(Vec4 a, Vec4 b){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_store(_mm_mul_ps(simd_load(a), simd_load(b)));
+#endif
+    return {{a.values[0] * b.values[0], a.values[1] * b.values[1], a.values[2] * b.values[2], a.values[3] * b.values[3]}};
+}
+
+constexpr Vec4 operator*(Vec4 v, float scalar){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_store(_mm_mul_ps(simd_load(v), _mm_set1_ps(scalar)));
+#endif
+    return {{v.values[0] * scalar, v.values[1] * scalar, v.values[2] * scalar, v.values[3] * scalar}};
+}
+
+constexpr float dot(Vec4 a, Vec4 b){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_dot(a, b);
+#endif
+    return a.values[0] * b.values[0] + a.values[1] * b.values[1] + a.values[2] * b.values[2] + a.values[3] * b.values[3];
+}
+
+constexpr Vec4 operator*(Mat4 m, Vec4 v){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_store(simd_mul(m, simd_load(v)));
+#endif
+    Vec4 result = {};
+    for(int column = 0; column < 4; column++){
+        for(int row = 0; row < 4; row++) result.values[row] += m.values[column].values[row] * v.values[column];
+    }
+    return result;
+}
+
+constexpr Mat4 operator*(Mat4 a, Mat4 b){
+#if defined(__SSE2__) || defined(_M_X64)
+    if(!__builtin_is_constant_evaluated()) return simd_mul(a, b);
+#endif
+    Mat4 result = {};
+    for(int column = 0; column < 4; column++) result.values[column] = a * b.values[column];
+    return result;
+}
+
+constexpr Mat4 identity_mat4(){
+    Mat4 result = {};
+    for(int idx = 0; idx < 4; idx++) result.values[idx].values[idx] = 1.0f;
+    return result;
+}
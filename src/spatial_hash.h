@@ -0,0 +1,154 @@
+#pragma once
+#include "engine_lib.h"
+
+//#####################################################################################################################################
+//                                                  Spatial Hash Structs
+//#####################################################################################################################################
+struct SpatialEntity{
+    IVec2 pos;      // top-left corner in world pixels, same space as get_tile(IVec2)
+    IVec2 size;
+};
+
+struct SpatialHashEntry{
+    IVec2 cell;
+    IVec2 pos;
+    IVec2 size;
+    int id;
+};
+
+// Entities are bucketed by the cell of their top-left corner, queries grow their area by the largest entity size seen
+// during the build. Buckets are contiguous ranges of `entries`, produced with a counting sort on every rebuild.
+struct SpatialHash{
+    int cellSize;
+    int bucketMask;
+    int maxEntities;
+    int entityCount;
+    IVec2 maxEntitySize;
+
+    int* bucketStart;           // bucketMask + 2 entries, bucketStart[b]..bucketStart[b+1] is the range of bucket b
+    int* entityBucket;          // scratch, bucket index per input entity
+    SpatialHashEntry* entries;
+};
+
+//#####################################################################################################################################
+//                                                  Spatial Hash Functions
+//#####################################################################################################################################
+IVec2 spatial_hash_cell(SpatialHash* hash, IVec2 worldPos){
+    return {floor_div(worldPos.x, hash->cellSize), floor_div(worldPos.y, hash->cellSize)};
+}
+
+int spatial_hash_bucket(SpatialHash* hash, IVec2 cell){
+    unsigned int h = ((unsigned int)cell.x * 73856093u) ^ ((unsigned int)cell.y * 19349663u);
+    return (int)(h & (unsigned int)hash->bucketMask);
+}
+
+// cellSize is in world pixels, pick a multiple of TILESIZE close to the typical entity size
+SpatialHash make_spatial_hash(BumpAllocator* bumpAllocator, int maxEntities, int cellSize){
+    SM_ASSERT(maxEntities > 0, "Spatial Hash needs room for at least one entity");
+    SM_ASSERT(cellSize > 0, "Spatial Hash cell size must be positive");
+
+    // Twice as many buckets as entities, rounded up to a power of two, keeps the load factor under 0.5
+    int bucketCount = 1;
+    while(bucketCount < maxEntities * 2) bucketCount <<= 1;
+
+    SpatialHash hash = {};
+    hash.cellSize = cellSize;
+    hash.bucketMask = bucketCount - 1;
+    hash.maxEntities = maxEntities;
+    hash.bucketStart = (int*)bump_alloc(bumpAllocator, sizeof(int) * (bucketCount + 1));
+    hash.entityBucket = (int*)bump_alloc(bumpAllocator, sizeof(int) * maxEntities);
+    hash.entries = (SpatialHashEntry*)bump_alloc(bumpAllocator, sizeof(SpatialHashEntry) * maxEntities);
+    return hash;
+}
+
+void spatial_hash_build(SpatialHash* hash, SpatialEntity* entities, int count){
+    SM_ASSERT_GUARD(count <= hash->maxEntities, , "Spatial Hash is full, %d entities for %d slots", count, hash->maxEntities);
+    int bucketCount = hash->bucketMask + 1;
+    memset(hash->bucketStart, 0, sizeof(int) * (bucketCount + 1));
+    hash->entityCount = count;
+    hash->maxEntitySize = {0, 0};
+
+    for(int idx = 0; idx < count; idx++){
+        int bucket = spatial_hash_bucket(hash, spatial_hash_cell(hash, entities[idx].pos));
+        hash->entityBucket[idx] = bucket;
+        hash->bucketStart[bucket + 1]++;
+        if(entities[idx].size.x > hash->maxEntitySize.x) hash->maxEntitySize.x = entities[idx].size.x;
+        if(entities[idx].size.y > hash->maxEntitySize.y) hash->maxEntitySize.y = entities[idx].size.y;
+    }
+
+    for(int bucket = 0; bucket < bucketCount; bucket++){
+        hash->bucketStart[bucket + 1] += hash->bucketStart[bucket];
+    }
+
+    // Scatter using bucketStart as the write cursor, afterwards bucketStart[b] holds the end of bucket b,
+    // shifting back by one restores the start offsets without a second counts array
+    for(int idx = 0; idx < count; idx++){
+        int slot = hash->bucketStart[hash->entityBucket[idx]]++;
+        SpatialHashEntry* entry = &hash->entries[slot];
+        entry->cell = spatial_hash_cell(hash, entities[idx].pos);
+        entry->pos = entities[idx].pos;
+        entry->size = entities[idx].size;
+        entry->id = idx;
+    }
+    for(int bucket = bucketCount; bucket > 0; bucket--){
+        hash->bucketStart[bucket] = hash->bucketStart[bucket - 1];
+    }
+    hash->bucketStart[0] = 0;
+}
+
+// Calls `overlaps(entry)` for every entity that could touch [min, max], each entity is visited at most once since
+// only entries whose own cell matches the visited cell are considered
+template <typename Fn>
+int spatial_hash_query(SpatialHash* hash, IVec2 min, IVec2 max, int* results, int maxResults, Fn overlaps){
+    IVec2 minCell = spatial_hash_cell(hash, {min.x - hash->maxEntitySize.x, min.y - hash->maxEntitySize.y});
+    IVec2 maxCell = spatial_hash_cell(hash, max);
+    int resultCount = 0;
+
+    for(int cy = minCell.y; cy <= maxCell.y; cy++){
+        for(int cx = minCell.x; cx <= maxCell.x; cx++){
+            int bucket = spatial_hash_bucket(hash, {cx, cy});
+            int end = hash->bucketStart[bucket + 1];
+            for(int slot = hash->bucketStart[bucket]; slot < end; slot++){
+                SpatialHashEntry* entry = &hash->entries[slot];
+                if(entry->cell.x != cx || entry->cell.y != cy) continue;
+                if(!overlaps(entry)) continue;
+                if(resultCount == maxResults){
+                    SM_WARN("Spatial Hash query dropped results, buffer holds %d", maxResults);
+                    return resultCount;
+                }
+                results[resultCount++] = entry->id;
+            }
+        }
+    }
+    return resultCount;
+}
+
+int spatial_hash_query_aabb(SpatialHash* hash, IVec2 pos, IVec2 size, int* results, int maxResults){
+    IVec2 max = {pos.x + size.x - 1, pos.y + size.y - 1};
+    return spatial_hash_query(hash, pos, max, results, maxResults, [&](SpatialHashEntry* entry){
+        return entry->pos.x < pos.x + size.x && pos.x < entry->pos.x + entry->size.x &&
+               entry->pos.y < pos.y + size.y && pos.y < entry->pos.y + entry->size.y;
+    });
+}
+
+int spatial_hash_query_point(SpatialHash* hash, IVec2 point, int* results, int maxResults){
+    return spatial_hash_query(hash, point, point, results, maxResults, [&](SpatialHashEntry* entry){
+        return point.x >= entry->pos.x && point.x < entry->pos.x + entry->size.x &&
+               point.y >= entry->pos.y && point.y < entry->pos.y + entry->size.y;
+    });
+}
+
+int spatial_hash_query_radius(SpatialHash* hash, IVec2 center, int radius, int* results, int maxResults){
+    IVec2 min = {center.x - radius, center.y - radius};
+    IVec2 max = {center.x + radius, center.y + radius};
+    long long radiusSq = (long long)radius * radius;
+    return spatial_hash_query(hash, min, max, results, maxResults, [&](SpatialHashEntry* entry){
+        int closestX = center.x < entry->pos.x ? entry->pos.x :
+                       center.x > entry->pos.x + entry->size.x - 1 ? entry->pos.x + entry->size.x - 1 : center.x;
+        int closestY = center.y < entry->pos.y ? entry->pos.y :
+                       center.y > entry->pos.y + entry->size.y - 1 ? entry->pos.y + entry->size.y - 1 : center.y;
+        long long dx = closestX - center.x;
+        long long dy = closestY - center.y;
+        return dx * dx + dy * dy <= radiusSq;
+    });
+}
@@ -0,0 +1,475 @@
+#include "engine_lib.h"
+#include "input.h"
+#include "render_interface.h"
+
+#ifndef STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#endif
+
+#include "palette.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+//#####################################################################################################################################
+//                                                  Software Renderer Constants
+//#####################################################################################################################################
+constexpr int SW_TILE_SIZE = 64;
+constexpr int SW_MAX_THREADS = 64;
+constexpr unsigned int SW_ALPHA_MASK = 0xFF000000;
+constexpr int SW_COMPARE_INVALID = -1;          // sw_compare_ppm could not read a matching golden image
+constexpr float SW_CLEAR_COLOR[3] = {119.0f/255.0f, 33.0f/255.0f, 111.0f/255.0f};   // same as gl_render, linear
+
+//#####################################################################################################################################
+//                                                  Software Renderer Structs
+//#####################################################################################################################################
+// RGBA8 sRGB pixels, R in the lowest byte. During the world pass alpha 0 marks a pixel nothing was drawn to yet, the
+// same role the depth buffer plays for gl_render: GL_GREATER against a clear depth of 0 lets only the first quad write a pixel
+struct SWFramebuffer{
+    int width, height;
+    unsigned int* pixels;
+};
+
+// A Transform mapped to framebuffer pixels, [x0, x1) x [y0, y1). texX/texY are the atlas coordinates at the first
+// pixel center, they advance by stepX/stepY per pixel like the interpolated texture coords of quad.vert
+struct SWQuad{
+    unsigned int* atlas;            // resolved page of the quad in its palette
+    unsigned char* indices;         // page of the quad in the indexed atlas, for passes that blend over the world
+    unsigned int* palette;
+    int x0, y0, x1, y1;
+    float texX, texY;
+    float stepX, stepY;
+    IVec2 texMin, texMax;
+};
+
+struct SWContext{
+    int atlasWidth, atlasHeight;    // of every page, see IndexedAtlas
+    int atlasPageCount;
+    unsigned int* resolved[PALETTE_COUNT];  // texels of all pages in each palette blended over the clear color, back in sRGB
+    unsigned char* indices;                 // of all pages, copied from the IndexedAtlas
+    unsigned int palettes[PALETTE_COUNT][MAX_PALETTE_COLORS];
+    long long textureTimeStamp;
+    int threadCount;
+    float srgbToLinear[256];
+    SWFramebuffer framebuffer;
+    unsigned char tilemap[TILEMAP_SIZE * TILEMAP_SIZE];     // copy of the tile index texture of gl_render
+};
+
+//#####################################################################################################################################
+//                                                  Software Renderer Globals
+//#####################################################################################################################################
+static SWContext swContext;
+
+//#####################################################################################################################################
+//                                                  Software Renderer Utility
+//#####################################################################################################################################
+float sw_srgb_to_linear(float value){
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+unsigned int sw_linear_to_srgb8(float value){
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+    float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return (unsigned int)(srgb * 255.0f + 0.5f);
+}
+
+unsigned int sw_clear_pixel(){
+    return sw_linear_to_srgb8(SW_CLEAR_COLOR[0]) | sw_linear_to_srgb8(SW_CLEAR_COLOR[1]) << 8 |
+           sw_linear_to_srgb8(SW_CLEAR_COLOR[2]) << 16 | SW_ALPHA_MASK;
+}
+
+// In the world pass only the first quad reaches a pixel and the framebuffer still holds the clear color, so the blend
+// in gl_render is texel over the clear color. That only depends on the texel, which lets the raster loop copy
+// precomputed colors instead of blending per pixel. Colors are resolved once per palette entry and then expanded to
+// every texel. Later passes blend over the world with sw_blend_pixel instead.
+void sw_resolve_atlas(IndexedAtlas* atlas){
+    for(int paletteID = 0; paletteID < PALETTE_COUNT; paletteID++){
+        unsigned int colors[MAX_PALETTE_COLORS];
+        for(int colorIdx = 0; colorIdx < MAX_PALETTE_COLORS; colorIdx++){
+            unsigned int texel = atlas->palettes[paletteID][colorIdx];
+            float alpha = (texel >> 24) / 255.0f;
+            unsigned int result = SW_ALPHA_MASK;
+            for(int channel = 0; channel < 3; channel++){
+                float color = swContext.srgbToLinear[(texel >> (channel * 8)) & 0xFF];
+                result |= sw_linear_to_srgb8(color * alpha + SW_CLEAR_COLOR[channel] * (1.0f - alpha)) << (channel * 8);
+            }
+            colors[colorIdx] = result;
+        }
+        for(int idx = 0; idx < swContext.atlasWidth * swContext.atlasHeight * swContext.atlasPageCount; idx++){
+            swContext.resolved[paletteID][idx] = colors[atlas->indices[idx]];
+        }
+    }
+}
+
+// The indexed atlas is only needed until it is resolved, storage is left as it was
+bool sw_load_atlas(BumpAllocator* storage){
+    size_t used = storage->used;
+    IndexedAtlas* atlas = load_indexed_atlas(storage);
+    storage->used = used;
+    SM_ASSERT_GUARD(atlas, false, "Failed to load the atlas");
+    if(atlas->width != swContext.atlasWidth || atlas->height != swContext.atlasHeight || atlas->pageCount != swContext.atlasPageCount){
+        for(int paletteID = 0; paletteID < PALETTE_COUNT; paletteID++){
+            free(swContext.resolved[paletteID]);
+            swContext.resolved[paletteID] = (unsigned int*)malloc(sizeof(unsigned int) * atlas->width * atlas->height * atlas->pageCount);
+        }
+        free(swContext.indices);
+        swContext.indices = (unsigned char*)malloc(atlas->width * atlas->height * atlas->pageCount);
+        swContext.atlasWidth = atlas->width;
+        swContext.atlasHeight = atlas->height;
+        swContext.atlasPageCount = atlas->pageCount;
+    }
+    sw_resolve_atlas(atlas);
+    memcpy(swContext.indices, atlas->indices, atlas->width * atlas->height * atlas->pageCount);
+    memcpy(swContext.palettes, atlas->palettes, sizeof(swContext.palettes));
+    swContext.textureTimeStamp = get_atlas_timestamp();
+    return true;
+}
+
+// Copies src into the pixels of dst that were not written yet
+void sw_blit_row(unsigned int* dst, unsigned int* src, int count){
+    int idx = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    {
+        __m128i alphaMask = _mm_set1_epi32((int)SW_ALPHA_MASK);
+        __m128i zero = _mm_setzero_si128();
+        for(; idx + 4 <= count; idx += 4){
+            __m128i pixels = _mm_loadu_si128((__m128i*)(dst + idx));
+            __m128i empty = _mm_cmpeq_epi32(_mm_and_si128(pixels, alphaMask), zero);
+            pixels = _mm_or_si128(_mm_andnot_si128(empty, pixels), _mm_and_si128(empty, _mm_loadu_si128((__m128i*)(src + idx))));
+            _mm_storeu_si128((__m128i*)(dst + idx), pixels);
+        }
+    }
+#endif
+    for(; idx < count; idx++){
+        if(!(dst[idx] & SW_ALPHA_MASK)) dst[idx] = src[idx];
+    }
+}
+
+// texel over dst the way GL blends into the sRGB render target, in linear space and encoded back to sRGB
+unsigned int sw_blend_pixel(unsigned int dst, unsigned int texel){
+    unsigned int alpha = texel >> 24;
+    if(alpha == 0) return dst;
+    if(alpha == 255) return texel;
+    float srcAlpha = alpha / 255.0f;
+    unsigned int result = SW_ALPHA_MASK;
+    for(int channel = 0; channel < 3; channel++){
+        float src = swContext.srgbToLinear[(texel >> (channel * 8)) & 0xFF];
+        float background = swContext.srgbToLinear[(dst >> (channel * 8)) & 0xFF];
+        result |= sw_linear_to_srgb8(src * srcAlpha + background * (1.0f - srcAlpha)) << (channel * 8);
+    }
+    return result;
+}
+
+// Pixels whose center lies in [start, end) along one axis, the same coverage rule the GL rasterizer uses
+void sw_pixel_span(float start, float end, int limit, int* first, int* last){
+    *first = (int)ceilf(start - 0.5f);
+    *last = (int)ceilf(end - 0.5f);
+    if(*first < 0) *first = 0;
+    if(*last > limit) *last = limit;
+}
+
+bool sw_setup_quad(Transform* transform, ViewRect view, Vec2 scale, SWQuad* quad){
+    if(transform->size.x <= 0.0f || transform->size.y <= 0.0f) return false;
+    int paletteIdx = transform->paletteIdx;
+    int atlasPage = transform->atlasPage;
+    paletteIdx = paletteIdx >= 0 && paletteIdx < PALETTE_COUNT ? paletteIdx : PALETTE_DEFAULT;
+    int pageOffset = (atlasPage >= 0 && atlasPage < swContext.atlasPageCount ? atlasPage : 0) * swContext.atlasWidth * swContext.atlasHeight;
+    quad->atlas = swContext.resolved[paletteIdx] + pageOffset;
+    quad->indices = swContext.indices + pageOffset;
+    quad->palette = swContext.palettes[paletteIdx];
+    float left = (transform->pos.x - view.min.x) * scale.x;
+    float top = (transform->pos.y - view.min.y) * scale.y;
+    sw_pixel_span(left, left + transform->size.x * scale.x, swContext.framebuffer.width, &quad->x0, &quad->x1);
+    sw_pixel_span(top, top + transform->size.y * scale.y, swContext.framebuffer.height, &quad->y0, &quad->y1);
+    if(quad->x0 >= quad->x1 || quad->y0 >= quad->y1) return false;
+
+    quad->stepX = transform->spriteSize.x / transform->size.x / scale.x;
+    quad->stepY = transform->spriteSize.y / transform->size.y / scale.y;
+    quad->texX = transform->atlasOffset.x + (quad->x0 + 0.5f - left) * quad->stepX;
+    quad->texY = transform->atlasOffset.y + (quad->y0 + 0.5f - top) * quad->stepY;
+    // texelFetch outside the texture returns nothing useful, stay inside both the sprite and the atlas
+    quad->texMin = {transform->atlasOffset.x > 0 ? transform->atlasOffset.x : 0, transform->atlasOffset.y > 0 ? transform->atlasOffset.y : 0};
+    quad->texMax = {transform->atlasOffset.x + transform->spriteSize.x - 1, transform->atlasOffset.y + transform->spriteSize.y - 1};
+    if(quad->texMax.x > swContext.atlasWidth - 1) quad->texMax.x = swContext.atlasWidth - 1;
+    if(quad->texMax.y > swContext.atlasHeight - 1) quad->texMax.y = swContext.atlasHeight - 1;
+    return quad->texMin.x <= quad->texMax.x && quad->texMin.y <= quad->texMax.y;
+}
+
+void sw_raster_quad(SWQuad* quad, int tileX0, int tileY0, int tileX1, int tileY1){
+    int x0 = quad->x0 > tileX0 ? quad->x0 : tileX0;
+    int x1 = quad->x1 < tileX1 ? quad->x1 : tileX1;
+    int y0 = quad->y0 > tileY0 ? quad->y0 : tileY0;
+    int y1 = quad->y1 < tileY1 ? quad->y1 : tileY1;
+    if(x0 >= x1 || y0 >= y1) return;
+
+    float texX = quad->texX + (x0 - quad->x0) * quad->stepX;
+    int firstTexX = (int)floorf(texX);
+    // Unscaled quads read a contiguous run of texels per row and go through the SIMD copy
+    bool contiguous = quad->stepX == 1.0f && firstTexX >= quad->texMin.x && firstTexX + (x1 - x0) - 1 <= quad->texMax.x;
+
+    for(int y = y0; y < y1; y++){
+        int texY = (int)floorf(quad->texY + (y - quad->y0) * quad->stepY);
+        texY = texY < quad->texMin.y ? quad->texMin.y : texY > quad->texMax.y ? quad->texMax.y : texY;
+        unsigned int* dst = &swContext.framebuffer.pixels[y * swContext.framebuffer.width + x0];
+        unsigned int* texels = &quad->atlas[texY * swContext.atlasWidth];
+        if(contiguous){
+            sw_blit_row(dst, texels + firstTexX, x1 - x0);
+            continue;
+        }
+        for(int x = x0; x < x1; x++, dst++){
+            if(*dst & SW_ALPHA_MASK) continue;
+            int tx = (int)floorf(texX + (x - x0) * quad->stepX);
+            tx = tx < quad->texMin.x ? quad->texMin.x : tx > quad->texMax.x ? quad->texMax.x : tx;
+            *dst = texels[tx];
+        }
+    }
+}
+
+// For the passes after the world. Depth is cleared before each of them, so the first quad of the pass to reach a
+// pixel blends over what is there and marks it in covered (one byte per pixel of the screen tile), even where the
+// texel is transparent
+void sw_blend_quad(SWQuad* quad, int tileX0, int tileY0, int tileX1, int tileY1, unsigned char* covered){
+    int x0 = quad->x0 > tileX0 ? quad->x0 : tileX0;
+    int x1 = quad->x1 < tileX1 ? quad->x1 : tileX1;
+    int y0 = quad->y0 > tileY0 ? quad->y0 : tileY0;
+    int y1 = quad->y1 < tileY1 ? quad->y1 : tileY1;
+    if(x0 >= x1 || y0 >= y1) return;
+
+    float texX = quad->texX + (x0 - quad->x0) * quad->stepX;
+    for(int y = y0; y < y1; y++){
+        int texY = (int)floorf(quad->texY + (y - quad->y0) * quad->stepY);
+        texY = texY < quad->texMin.y ? quad->texMin.y : texY > quad->texMax.y ? quad->texMax.y : texY;
+        unsigned int* dst = &swContext.framebuffer.pixels[y * swContext.framebuffer.width + x0];
+        unsigned char* indices = &quad->indices[texY * swContext.atlasWidth];
+        unsigned char* coveredRow = &covered[(y - tileY0) * SW_TILE_SIZE + (x0 - tileX0)];
+        for(int x = x0; x < x1; x++, dst++, coveredRow++){
+            if(*coveredRow) continue;
+            *coveredRow = 1;
+            int tx = (int)floorf(texX + (x - x0) * quad->stepX);
+            tx = tx < quad->texMin.x ? quad->texMin.x : tx > quad->texMax.x ? quad->texMax.x : tx;
+            *dst = sw_blend_pixel(*dst, quad->palette[indices[tx]]);
+        }
+    }
+}
+
+void sw_upload_tilemap(){
+    Tilemap* tilemap = &renderData->tilemap;
+    for(int idx = 0; idx < tilemap->uploads.count; idx++){
+        TilemapUpload upload = tilemap->uploads.elements[idx];
+        for(int row = 0; row < upload.size.y; row++){
+            int y = (upload.pos.y + row) & (TILEMAP_SIZE - 1);
+            memcpy(&swContext.tilemap[y * TILEMAP_SIZE + (upload.pos.x & (TILEMAP_SIZE - 1))],
+                   tilemap->uploadData + upload.dataOffset + row * upload.size.x, upload.size.x);
+        }
+    }
+    clear_tilemap_uploads();
+}
+
+// tilemap.frag for the pixels of one screen tile that are still empty. At one pixel per world unit each tile
+// covers a contiguous run of texels per row and goes through the SIMD copy
+void sw_raster_tilemap(ViewRect view, Vec2 scale, int tileX0, int tileY0, int tileX1, int tileY1){
+    Tilemap* tilemap = &renderData->tilemap;
+    int paletteIdx = tilemap->palette >= 0 && tilemap->palette < PALETTE_COUNT ? tilemap->palette : PALETTE_DEFAULT;
+    int atlasPage = tilemap->atlasPage >= 0 && tilemap->atlasPage < swContext.atlasPageCount ? tilemap->atlasPage : 0;
+    unsigned int* atlas = swContext.resolved[paletteIdx] + atlasPage * swContext.atlasWidth * swContext.atlasHeight;
+    int tileSize = tilemap->tileSize;
+    bool unscaled = scale.x == 1.0f;
+    int offsetX = (int)floorf(view.min.x + 0.5f);
+
+    for(int y = tileY0; y < tileY1; y++){
+        int worldY = (int)floorf(view.min.y + (y + 0.5f) / scale.y);
+        int tileY = floor_div(worldY, tileSize);
+        if(tileY < 0 || tileY >= tilemap->sizeInTiles.y) continue;
+        unsigned char* tileRow = &swContext.tilemap[(tileY & (TILEMAP_SIZE - 1)) * TILEMAP_SIZE];
+        unsigned int* dst = &swContext.framebuffer.pixels[y * swContext.framebuffer.width];
+        for(int x = tileX0; x < tileX1;){
+            int worldX = unscaled ? x + offsetX : (int)floorf(view.min.x + (x + 0.5f) / scale.x);
+            int tileX = floor_div(worldX, tileSize);
+            int runEnd = unscaled ? min(tileX1, x + (tileX + 1) * tileSize - worldX) : x + 1;
+            int runStart = x;
+            x = runEnd;
+            if(tileX < 0 || tileX >= tilemap->sizeInTiles.x) continue;
+            int tileIdx = tileRow[tileX & (TILEMAP_SIZE - 1)];
+            if(!tileIdx || tileIdx > MAX_TILEMAP_TILES) continue;
+            IVec2 texel = tilemap->atlasOffsets[tileIdx - 1] + IVec2{worldX - tileX * tileSize, worldY - tileY * tileSize};
+            int count = runEnd - runStart;
+            if(texel.x < 0 || texel.y < 0 || texel.x + count > swContext.atlasWidth || texel.y >= swContext.atlasHeight) continue;
+            sw_blit_row(dst + runStart, &atlas[texel.y * swContext.atlasWidth + texel.x], count);
+        }
+    }
+}
+
+//#####################################################################################################################################
+//                                                  Software Renderer Functions
+//#####################################################################################################################################
+bool sw_init(BumpAllocator* persistentStorage, int width, int height){
+    for(int idx = 0; idx < 256; idx++) swContext.srgbToLinear[idx] = sw_srgb_to_linear(idx / 255.0f);
+    swContext.framebuffer.width = width;
+    swContext.framebuffer.height = height;
+    swContext.framebuffer.pixels = (unsigned int*)bump_alloc(persistentStorage, sizeof(unsigned int) * width * height);
+    SM_ASSERT_GUARD(swContext.framebuffer.pixels, false, "Failed to allocate %dx%d Framebuffer", width, height);
+
+    swContext.threadCount = (int)std::thread::hardware_concurrency();
+    if(swContext.threadCount < 1) swContext.threadCount = 1;
+    if(swContext.threadCount > SW_MAX_THREADS) swContext.threadCount = SW_MAX_THREADS;
+    return sw_load_atlas(persistentStorage);
+}
+
+// Renders the passes in renderData the way gl_render does, into swContext.framebuffer. Quads are binned into
+// SW_TILE_SIZE screen tiles with a counting sort that keeps submission order, then tiles are shared out to threads
+void sw_render(BumpAllocator* transientStorage){
+    if(get_atlas_timestamp() > swContext.textureTimeStamp) sw_load_atlas(transientStorage);
+
+    sw_upload_tilemap();
+
+    SWFramebuffer* framebuffer = &swContext.framebuffer;
+    memset(framebuffer->pixels, 0, sizeof(unsigned int) * framebuffer->width * framebuffer->height);
+
+    IVec2 tiles = {(framebuffer->width + SW_TILE_SIZE - 1) / SW_TILE_SIZE, (framebuffer->height + SW_TILE_SIZE - 1) / SW_TILE_SIZE};
+    int tileCount = tiles.x * tiles.y;
+
+    int transformCount = renderData->transforms.count;
+    SWQuad* quads = (SWQuad*)bump_alloc(transientStorage, sizeof(SWQuad) * (transformCount + 1));
+    int* binStart = (int*)bump_alloc(transientStorage, sizeof(int) * (tileCount + 1));
+    SM_ASSERT_GUARD(quads && binStart, , "Out of transient memory for %d quads", transformCount);
+    memset(binStart, 0, sizeof(int) * (tileCount + 1));
+
+    int quadCount = 0;
+    long long binnedCount = 0;
+    int passFirstQuad[RENDER_PASS_COUNT + 1];   // the quads of pass n are [passFirstQuad[n], passFirstQuad[n + 1])
+    ViewRect worldView = {};
+    Vec2 worldScale = {};
+    for(int passID = 0; passID < RENDER_PASS_COUNT; passID++){
+        RenderPass pass = get_render_pass(passID);
+        ViewRect view = get_camera_view(get_pass_camera(passID));
+        Vec2 scale = {framebuffer->width / (view.max.x - view.min.x), framebuffer->height / (view.max.y - view.min.y)};
+        passFirstQuad[passID] = quadCount;
+        if(passID == RENDER_PASS_WORLD){
+            worldView = view;
+            worldScale = scale;
+        }
+        for(int idx = pass.instanceOffset; idx < pass.instanceOffset + pass.instanceCount; idx++){
+            SWQuad* quad = &quads[quadCount];
+            if(!sw_setup_quad(&renderData->transforms.elements[idx], view, scale, quad)) continue;
+            quadCount++;
+            for(int ty = quad->y0 / SW_TILE_SIZE; ty <= (quad->y1 - 1) / SW_TILE_SIZE; ty++){
+                for(int tx = quad->x0 / SW_TILE_SIZE; tx <= (quad->x1 - 1) / SW_TILE_SIZE; tx++){
+                    binStart[ty * tiles.x + tx + 1]++;
+                    binnedCount++;
+                }
+            }
+        }
+    }
+    passFirstQuad[RENDER_PASS_COUNT] = quadCount;
+    for(int tile = 0; tile < tileCount; tile++) binStart[tile + 1] += binStart[tile];
+
+    int* bins = (int*)bump_alloc(transientStorage, sizeof(int) * (binnedCount + 1));
+    int* binCursor = (int*)bump_alloc(transientStorage, sizeof(int) * tileCount);
+    SM_ASSERT_GUARD(bins && binCursor, , "Out of transient memory for %lld binned quads", binnedCount);
+    memcpy(binCursor, binStart, sizeof(int) * tileCount);
+    for(int idx = 0; idx < quadCount; idx++){
+        SWQuad* quad = &quads[idx];
+        for(int ty = quad->y0 / SW_TILE_SIZE; ty <= (quad->y1 - 1) / SW_TILE_SIZE; ty++){
+            for(int tx = quad->x0 / SW_TILE_SIZE; tx <= (quad->x1 - 1) / SW_TILE_SIZE; tx++){
+                bins[binCursor[ty * tiles.x + tx]++] = idx;
+            }
+        }
+    }
+
+    Tilemap* tilemap = &renderData->tilemap;
+    bool drawTilemap = tilemap->sizeInTiles.x > 0 && tilemap->sizeInTiles.y > 0 && tilemap->tileSize > 0;
+    unsigned int clearPixel = sw_clear_pixel();
+    std::atomic<int> nextTile(0);
+    auto raster_tiles = [&](){
+        for(int tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1)){
+            int tileX0 = (tile % tiles.x) * SW_TILE_SIZE;
+            int tileY0 = (tile / tiles.x) * SW_TILE_SIZE;
+            int tileX1 = tileX0 + SW_TILE_SIZE < framebuffer->width ? tileX0 + SW_TILE_SIZE : framebuffer->width;
+            int tileY1 = tileY0 + SW_TILE_SIZE < framebuffer->height ? tileY0 + SW_TILE_SIZE : framebuffer->height;
+            // Bins keep submission order, so the quads of each pass are one run of the bin
+            int slot = binStart[tile], binEnd = binStart[tile + 1];
+            if(drawTilemap) sw_raster_tilemap(worldView, worldScale, tileX0, tileY0, tileX1, tileY1);
+            for(; slot < binEnd && bins[slot] < passFirstQuad[RENDER_PASS_WORLD + 1]; slot++){
+                sw_raster_quad(&quads[bins[slot]], tileX0, tileY0, tileX1, tileY1);
+            }
+            for(int y = tileY0; y < tileY1; y++){
+                unsigned int* row = &framebuffer->pixels[y * framebuffer->width];
+                for(int x = tileX0; x < tileX1; x++){
+                    if(!(row[x] & SW_ALPHA_MASK)) row[x] = clearPixel;
+                }
+            }
+
+            unsigned char covered[SW_TILE_SIZE * SW_TILE_SIZE];
+            for(int passID = RENDER_PASS_WORLD + 1; passID < RENDER_PASS_COUNT && slot < binEnd; passID++){
+                if(bins[slot] >= passFirstQuad[passID + 1]) continue;
+                memset(covered, 0, sizeof(covered));
+                for(; slot < binEnd && bins[slot] < passFirstQuad[passID + 1]; slot++){
+                    sw_blend_quad(&quads[bins[slot]], tileX0, tileY0, tileX1, tileY1, covered);
+                }
+            }
+        }
+    };
+
+    int threadCount = swContext.threadCount < tileCount ? swContext.threadCount : tileCount;
+    std::thread threads[SW_MAX_THREADS];
+    for(int thread = 1; thread < threadCount; thread++) threads[thread] = std::thread(raster_tiles);
+    raster_tiles();
+    for(int thread = 1; thread < threadCount; thread++) threads[thread].join();
+
+    clear_render_passes();
+}
+
+// Binary PPM (P6), what the headless runner writes and compares against golden images
+bool sw_write_ppm(char* path, BumpAllocator* transientStorage){
+    SWFramebuffer* framebuffer = &swContext.framebuffer;
+    char header[64];
+    int headerSize = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", framebuffer->width, framebuffer->height);
+    int size = headerSize + framebuffer->width * framebuffer->height * 3;
+    char* buffer = bump_alloc(transientStorage, size);
+    SM_ASSERT_GUARD(buffer, false, "Out of transient memory for %s", path);
+
+    memcpy(buffer, header, headerSize);
+    unsigned char* rgb = (unsigned char*)buffer + headerSize;
+    for(int idx = 0; idx < framebuffer->width * framebuffer->height; idx++){
+        unsigned int pixel = framebuffer->pixels[idx];
+        *rgb++ = pixel & 0xFF;
+        *rgb++ = (pixel >> 8) & 0xFF;
+        *rgb++ = (pixel >> 16) & 0xFF;
+    }
+    write_file(path, buffer, size);
+    return true;
+}
+
+// Number of pixels that differ from the PPM at path by more than tolerance in any channel, SW_COMPARE_INVALID if it
+// is missing, can not be parsed or does not match the framebuffer size
+int sw_compare_ppm(char* path, int tolerance, BumpAllocator* transientStorage){
+    SWFramebuffer* framebuffer = &swContext.framebuffer;
+    int fileSize = 0;
+    char* data = read_file(path, &fileSize, transientStorage);
+    if(!data) return SW_COMPARE_INVALID;
+
+    int width = 0, height = 0, maxValue = 0, headerSize = 0;
+    if(sscanf(data, "P6 %d %d %d%n", &width, &height, &maxValue, &headerSize) != 3) return SW_COMPARE_INVALID;
+    if(width != framebuffer->width || height != framebuffer->height || maxValue != 255) return SW_COMPARE_INVALID;
+    headerSize++;
+    if(fileSize < headerSize + width * height * 3) return SW_COMPARE_INVALID;
+
+    unsigned char* rgb = (unsigned char*)data + headerSize;
+    int differentCount = 0;
+    for(int idx = 0; idx < width * height; idx++, rgb += 3){
+        unsigned int pixel = framebuffer->pixels[idx];
+        for(int channel = 0; channel < 3; channel++){
+            int diff = (int)((pixel >> (channel * 8)) & 0xFF) - rgb[channel];
+            if(diff > tolerance || diff < -tolerance){
+                differentCount++;
+                break;
+            }
+        }
+    }
+    return differentCount;
+}
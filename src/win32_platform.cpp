@@ -158,7 +158,8 @@ bool platform_create_window(int width, int height, char* title){
     ShowWindow(window, SW_SHOW);
     return true;
 }
-void platform_update_window(){
+bool platform_update_window(){
+    bool hadEvents = false;
     {
         for(int keyCode = 0; keyCode < KEY_COUNT; keyCode++){
             input->keys[keyCode].justReleased = false;
@@ -172,6 +173,7 @@ void platform_update_window(){
     while(PeekMessageA(&msg, window, 0, 0, PM_REMOVE)){
         TranslateMessage(&msg);
         DispatchMessageA(&msg);
+        hadEvents = true;
     }
 
     {
@@ -184,7 +186,15 @@ void platform_update_window(){
         input->relMouse = input->mousePos - input->preMousePos;
 
         input->mousePosWorld = screen_to_world(input->mousePos);
+        // The cursor moving outside the window sends no messages
+        if(input->relMouse.x || input->relMouse.y) hadEvents = true;
     }
+    return hadEvents;
+}
+
+void platform_wait_for_events(long long timeoutNs){
+    DWORD timeoutMs = timeoutNs > 0 ? (DWORD)((timeoutNs + 999999) / 1000000) : 0;
+    MsgWaitForMultipleObjects(0, nullptr, FALSE, timeoutMs, QS_ALLINPUT);
 }
 
 void* platform_load_gl_function(char* funName){
@@ -204,6 +214,44 @@ void platform_swap_buffers(){
     SwapBuffers(dc);
 }
 
+bool platform_set_swap_interval(int interval){
+    // Looked up directly, platform_load_gl_function asserts on extensions the driver does not have
+    static PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
+    static PFNWGLGETEXTENSIONSSTRINGEXTPROC wglGetExtensionsStringEXT =
+        (PFNWGLGETEXTENSIONSSTRINGEXTPROC)wglGetProcAddress("wglGetExtensionsStringEXT");
+    if(!wglSwapIntervalEXT) return false;
+    if(interval < 0){
+        const char* extensions = wglGetExtensionsStringEXT ? wglGetExtensionsStringEXT() : nullptr;
+        if(!extensions || !strstr(extensions, "WGL_EXT_swap_control_tear")) return false;
+    }
+    return wglSwapIntervalEXT(interval);
+}
+
+long long platform_get_time_ns(){
+    static LARGE_INTEGER frequency;
+    if(!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split to keep counter * 1e9 from overflowing
+    long long seconds = counter.QuadPart / frequency.QuadPart;
+    long long remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ll + remainder * 1000000000ll / frequency.QuadPart;
+}
+
+void platform_sleep_ns(long long nanoseconds){
+    // High resolution timers (Windows 10 1803+) wake within ~0.5 ms, the fallback is bound to the scheduler tick
+    #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+    #endif
+    static HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    static HANDLE fallbackTimer = timer ? nullptr : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    HANDLE activeTimer = timer ? timer : fallbackTimer;
+    if(nanoseconds <= 0 || !activeTimer) return;
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(nanoseconds / 100);  // relative, in 100 ns units
+    if(SetWaitableTimer(activeTimer, &dueTime, 0, nullptr, nullptr, FALSE)) WaitForSingleObject(activeTimer, INFINITE);
+}
+
 
 
 void* platform_load_dynamic_library(char* dll){
@@ -224,6 +272,37 @@ bool platform_free_dynamic_library(void* dll){
     return (bool)freeResult;
 }
 
+void* platform_map_file(char* path, long long* size){
+    *size = 0;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(file == INVALID_HANDLE_VALUE) return nullptr;
+
+    // A mapping needs at least one byte, an empty file is nothing to map rather than an error
+    LARGE_INTEGER fileSize = {};
+    bool hasSize = GetFileSizeEx(file, &fileSize);
+    if(hasSize && fileSize.QuadPart == 0){
+        CloseHandle(file);
+        return nullptr;
+    }
+    void* view = nullptr;
+    if(hasSize){
+        HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if(mapping){
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            // The view keeps the mapping alive, both handles can go
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    SM_ASSERT_GUARD(view, nullptr, "Failed to map File: %s", path);
+    *size = fileSize.QuadPart;
+    return view;
+}
+
+void platform_unmap_file(void* data){
+    if(data) UnmapViewOfFile(data);
+}
+
 void platform_fill_keycode_lookup_table()
 {
   KeyCodeLookupTable[VK_LBUTTON] = KEY_MOUSE_LEFT;
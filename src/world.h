@@ -0,0 +1,553 @@
+#pragma once
+#include "engine_lib.h"
+#include "render_interface.h"
+#include "level.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+//#####################################################################################################################################
+//                                                  World Constants
+//#####################################################################################################################################
+constexpr int CHUNK_SHIFT = 5;
+constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;                // tiles per chunk side
+constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+constexpr int CHUNK_TILE_COUNT = CHUNK_SIZE * CHUNK_SIZE;
+constexpr int MAX_RESIDENT_CHUNKS = 4096;                   // upper bound for ChunkWorld::chunkBudget, ~4 MB of tiles
+constexpr int CHUNK_TABLE_SIZE = MAX_RESIDENT_CHUNKS * 2;   // power of two, load factor stays under 0.5
+constexpr int CHUNK_QUEUE_SIZE = 1024;                      // power of two
+constexpr int MAX_CHUNK_REQUESTS_PER_FRAME = 64;
+constexpr float CHUNK_PREFETCH_SECONDS = 0.5f;
+constexpr int MAX_SPILLED_CHUNKS = 1 << 16;
+static_assert(CHUNK_SIZE == LEVEL_CHUNK_SIZE, "Chunks and level file chunks have to line up");
+
+// Neighbour n of a tile for its neigbour mask, the first 8 are the direct neighbours, the last 4 are two tiles away
+constexpr int NEIGHBOUR_OFFSETS[24] = {  0,-1,   -1, 0,    1, 0,    0, 1,
+                                        -1,-1,    1,-1,   -1, 1,    1, 1,
+                                         0,-2,   -2, 0,    2, 0,    0, 2};
+
+//#####################################################################################################################################
+//                                                  World Structs
+//#####################################################################################################################################
+struct Tile{
+    unsigned char neigbourMask : 5;
+    unsigned char isVisible : 1;
+};
+
+enum ChunkState{
+    CHUNK_FREE,
+    CHUNK_LOADING,      // owned by the loader thread until it publishes CHUNK_READY
+    CHUNK_READY,
+    CHUNK_SAVING,       // evicted, the loader thread writes it out and hands the slot back as CHUNK_FREE
+};
+
+struct Chunk{
+    std::atomic<int> state;
+    IVec2 coord;
+    bool dirty;
+    long long lastUsedFrame;
+    Tile tiles[CHUNK_TILE_COUNT];   // row-major, tiles[y * CHUNK_SIZE + x]
+};
+
+enum ChunkRequestType{ CHUNK_REQUEST_LOAD, CHUNK_REQUEST_SAVE };
+struct ChunkRequest{
+    ChunkRequestType type;
+    int slot;
+    int spilledNeighbours;      // loads only, bit (dy + 1) * 3 + dx + 1 marks a neighbour whose tiles are in a spill file
+};
+
+// Single producer (the game on the main thread) and single consumer (the chunk loader thread)
+struct ChunkRequestQueue{
+    ChunkRequest requests[CHUNK_QUEUE_SIZE];
+    std::atomic<int> head;
+    std::atomic<int> tail;
+};
+
+// Only the main thread touches the table and picks slots, the loader thread only fills or writes the chunk it was handed
+struct ChunkWorld{
+    IVec2 sizeInTiles;
+    IVec2 sizeInChunks;
+    int chunkBudget;
+    long long frame;
+    char directory[256];            // edited chunks are spilled here as chunk_<x>_<y>.bin until the level is saved
+    LevelView level;                // mapped level file, chunks that were never spilled are decoded from here
+    bool saveRequested;             // set by the game, the platform side owns the file mapping and does the save
+
+    std::atomic<bool> loaderRunning;
+    std::atomic<int> completedRequests;
+    ChunkRequestQueue queue;
+    Array<IVec2, MAX_SPILLED_CHUNKS> spilledChunks;
+    Array<IVec2, MAX_RESIDENT_CHUNKS + MAX_CHUNK_REQUESTS_PER_FRAME> loadingChunks;   // until collect_loaded_chunks
+
+    int slotCursor;
+    unsigned long long lastChunkKey;
+    int lastChunkSlot;              // one entry cache, neighbouring get_tile calls mostly land in the same chunk
+    int chunkTable[CHUNK_TABLE_SIZE];   // slot + 1, 0 marks an empty entry
+    Chunk chunks[MAX_RESIDENT_CHUNKS];
+};
+
+//#####################################################################################################################################
+//                                                  World Globals
+//#####################################################################################################################################
+static ChunkWorld* chunkWorld;
+
+//#####################################################################################################################################
+//                                                  World Utility
+//#####################################################################################################################################
+// The coordinate pair itself, so keys and the spill files behind them do not depend on the size of the world.
+// Ordered by (y, x) for the non negative coordinates inside the world
+unsigned long long chunk_key(IVec2 chunkCoord){ return (unsigned long long)(unsigned int)chunkCoord.y << 32 | (unsigned int)chunkCoord.x; }
+
+IVec2 chunk_key_coord(unsigned long long key){ return {(int)(unsigned int)key, (int)(unsigned int)(key >> 32)}; }
+
+// Bit n of solidBits is set when neighbour n (see NEIGHBOUR_OFFSETS) is solid or outside the world
+int neigbour_mask_from_solid(int solidBits){
+    int emptyNeighbours = ~solidBits & 0xFF;
+    if(!emptyNeighbours) return (solidBits & 0xF00) == 0xF00 ? 20 : solidBits & 0b1111;
+    // A single open diagonal picks one of the inner corner tiles 16..19
+    if(!(emptyNeighbours & (emptyNeighbours - 1)) && emptyNeighbours >= BIT(4)){
+        return emptyNeighbours == BIT(4) ? 16 : emptyNeighbours == BIT(5) ? 17 : emptyNeighbours == BIT(6) ? 18 : 19;
+    }
+    return solidBits & 0b1111;
+}
+
+int chunk_table_home(unsigned long long key){ return (int)((key * 0x9E3779B97F4A7C15ull) >> 32) & (CHUNK_TABLE_SIZE - 1); }
+
+void get_chunk_path(ChunkWorld* world, IVec2 chunkCoord, char* buffer, int bufferSize){
+    snprintf(buffer, bufferSize, "%s/chunk_%d_%d.bin", world->directory, chunkCoord.x, chunkCoord.y);
+}
+
+bool push_chunk_request(ChunkWorld* world, ChunkRequestType type, int slot, int spilledNeighbours = 0){
+    int tail = world->queue.tail.load(std::memory_order_relaxed);
+    int head = world->queue.head.load(std::memory_order_acquire);
+    if(tail - head == CHUNK_QUEUE_SIZE) return false;
+    world->queue.requests[tail & (CHUNK_QUEUE_SIZE - 1)] = {type, slot, spilledNeighbours};
+    world->queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool pop_chunk_request(ChunkWorld* world, ChunkRequest* request){
+    int head = world->queue.head.load(std::memory_order_relaxed);
+    int tail = world->queue.tail.load(std::memory_order_acquire);
+    if(head == tail) return false;
+    *request = world->queue.requests[head & (CHUNK_QUEUE_SIZE - 1)];
+    world->queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+//#####################################################################################################################################
+//                                                  Chunk Table
+//#####################################################################################################################################
+int find_chunk_slot(ChunkWorld* world, unsigned long long key){
+    if(key == world->lastChunkKey && world->lastChunkSlot >= 0) return world->lastChunkSlot;
+    for(int idx = chunk_table_home(key);; idx = (idx + 1) & (CHUNK_TABLE_SIZE - 1)){
+        int entry = world->chunkTable[idx];
+        if(!entry) return -1;
+        Chunk* chunk = &world->chunks[entry - 1];
+        if(chunk_key(chunk->coord) == key){
+            world->lastChunkKey = key;
+            world->lastChunkSlot = entry - 1;
+            return entry - 1;
+        }
+    }
+}
+
+void insert_chunk_slot(ChunkWorld* world, unsigned long long key, int slot){
+    int idx = chunk_table_home(key);
+    while(world->chunkTable[idx]) idx = (idx + 1) & (CHUNK_TABLE_SIZE - 1);
+    world->chunkTable[idx] = slot + 1;
+}
+
+// Backward shift deletion, keeps every probe chain intact without tombstones
+void remove_chunk_slot(ChunkWorld* world, unsigned long long key){
+    int idx = chunk_table_home(key);
+    while(world->chunkTable[idx]){
+        if(chunk_key(world->chunks[world->chunkTable[idx] - 1].coord) == key) break;
+        idx = (idx + 1) & (CHUNK_TABLE_SIZE - 1);
+    }
+    if(!world->chunkTable[idx]) return;
+
+    int hole = idx;
+    for(int next = (hole + 1) & (CHUNK_TABLE_SIZE - 1); world->chunkTable[next]; next = (next + 1) & (CHUNK_TABLE_SIZE - 1)){
+        int home = chunk_table_home(chunk_key(world->chunks[world->chunkTable[next] - 1].coord));
+        // Move the entry into the hole unless its home lies cyclically in (hole, next]
+        bool homeBetween = (hole <= next) ? (home > hole && home <= next) : (home > hole || home <= next);
+        if(homeBetween) continue;
+        world->chunkTable[hole] = world->chunkTable[next];
+        hole = next;
+    }
+    world->chunkTable[hole] = 0;
+    world->lastChunkSlot = -1;
+}
+
+//#####################################################################################################################################
+//                                                  World Functions
+//#####################################################################################################################################
+void init_chunk_world(ChunkWorld* world, IVec2 sizeInTiles, const char* directory, int chunkBudget = MAX_RESIDENT_CHUNKS){
+    SM_ASSERT(chunkBudget > 0 && chunkBudget <= MAX_RESIDENT_CHUNKS, "Chunk budget %d is outside [1, %d]", chunkBudget, MAX_RESIDENT_CHUNKS);
+    world->sizeInTiles = sizeInTiles;
+    world->sizeInChunks = {(sizeInTiles.x + CHUNK_MASK) >> CHUNK_SHIFT, (sizeInTiles.y + CHUNK_MASK) >> CHUNK_SHIFT};
+    world->chunkBudget = chunkBudget;
+    world->lastChunkSlot = -1;
+    snprintf(world->directory, sizeof(world->directory), "%s", directory);
+    create_directory(world->directory);
+}
+
+Chunk* get_chunk(ChunkWorld* world, IVec2 chunkCoord){
+    int slot = find_chunk_slot(world, chunk_key(chunkCoord));
+    if(slot < 0) return nullptr;
+    Chunk* chunk = &world->chunks[slot];
+    if(chunk->state.load(std::memory_order_acquire) != CHUNK_READY) return nullptr;
+    return chunk;
+}
+
+// nullptr outside the world and for chunks that are not streamed in yet
+Tile* get_world_tile(ChunkWorld* world, int x, int y){
+    if(x < 0 || x >= world->sizeInTiles.x || y < 0 || y >= world->sizeInTiles.y) return nullptr;
+    Chunk* chunk = get_chunk(world, {x >> CHUNK_SHIFT, y >> CHUNK_SHIFT});
+    if(!chunk) return nullptr;
+    return &chunk->tiles[(y & CHUNK_MASK) * CHUNK_SIZE + (x & CHUNK_MASK)];
+}
+
+void mark_tile_dirty(ChunkWorld* world, int x, int y){
+    if(x < 0 || x >= world->sizeInTiles.x || y < 0 || y >= world->sizeInTiles.y) return;
+    Chunk* chunk = get_chunk(world, {x >> CHUNK_SHIFT, y >> CHUNK_SHIFT});
+    if(chunk) chunk->dirty = true;
+}
+
+int find_spilled_chunk(ChunkWorld* world, IVec2 chunkCoord){
+    for(int idx = 0; idx < world->spilledChunks.count; idx++){
+        if(world->spilledChunks[idx] == chunkCoord) return idx;
+    }
+    return -1;
+}
+
+// One pass over the spilled chunks, bit (dy + 1) * 3 + dx + 1 for every neighbour of chunkCoord among them
+int get_spilled_neighbours(ChunkWorld* world, IVec2 chunkCoord){
+    int spilledNeighbours = 0;
+    for(int idx = 0; idx < world->spilledChunks.count; idx++){
+        IVec2 offset = world->spilledChunks[idx] - chunkCoord;
+        if(offset.x < -1 || offset.x > 1 || offset.y < -1 || offset.y > 1 || (!offset.x && !offset.y)) continue;
+        spilledNeighbours |= BIT((offset.y + 1) * 3 + offset.x + 1);
+    }
+    return spilledNeighbours;
+}
+
+int acquire_chunk_slot(ChunkWorld* world){
+    for(int n = 0; n < world->chunkBudget; n++){
+        int slot = world->slotCursor;
+        world->slotCursor = (world->slotCursor + 1) % world->chunkBudget;
+        if(world->chunks[slot].state.load(std::memory_order_acquire) == CHUNK_FREE) return slot;
+    }
+
+    // Budget is used up, evict the least recently used chunk that was not needed this frame
+    int victim = -1;
+    for(int slot = 0; slot < world->chunkBudget; slot++){
+        Chunk* chunk = &world->chunks[slot];
+        if(chunk->state.load(std::memory_order_acquire) != CHUNK_READY || chunk->lastUsedFrame == world->frame) continue;
+        if(victim < 0 || chunk->lastUsedFrame < world->chunks[victim].lastUsedFrame) victim = slot;
+    }
+    if(victim < 0) return -1;
+
+    Chunk* chunk = &world->chunks[victim];
+    if(chunk->dirty){
+        // A chunk spilled before is written over its old spill file and keeps its one entry
+        bool spilledBefore = find_spilled_chunk(world, chunk->coord) >= 0;
+        if(!spilledBefore && world->spilledChunks.is_full()){
+            SM_WARN("Too many spilled chunks, save the level to free them");
+            return -1;
+        }
+        if(!push_chunk_request(world, CHUNK_REQUEST_SAVE, victim)) return -1;
+        if(!spilledBefore) world->spilledChunks.add(chunk->coord);
+        remove_chunk_slot(world, chunk_key(chunk->coord));
+        chunk->state.store(CHUNK_SAVING, std::memory_order_release);
+        return -1;
+    }
+    remove_chunk_slot(world, chunk_key(chunk->coord));
+    chunk->state.store(CHUNK_FREE, std::memory_order_release);
+    return victim;
+}
+
+// Returns false once no more requests can be issued this frame
+bool request_chunk(ChunkWorld* world, IVec2 chunkCoord, int* requestBudget){
+    unsigned long long key = chunk_key(chunkCoord);
+    int slot = find_chunk_slot(world, key);
+    if(slot >= 0){
+        world->chunks[slot].lastUsedFrame = world->frame;
+        return true;
+    }
+    if(*requestBudget <= 0) return false;
+
+    slot = acquire_chunk_slot(world);
+    if(slot < 0) return false;
+    Chunk* chunk = &world->chunks[slot];
+    chunk->coord = chunkCoord;
+    chunk->dirty = false;
+    chunk->lastUsedFrame = world->frame;
+    chunk->state.store(CHUNK_LOADING, std::memory_order_release);
+    if(world->loadingChunks.is_full() || !push_chunk_request(world, CHUNK_REQUEST_LOAD, slot, get_spilled_neighbours(world, chunkCoord))){
+        chunk->state.store(CHUNK_FREE, std::memory_order_release);
+        return false;
+    }
+    insert_chunk_slot(world, key, slot);
+    world->loadingChunks.add(chunkCoord);
+    (*requestBudget)--;
+    return true;
+}
+
+bool request_chunks(ChunkWorld* world, IVec2 minChunk, IVec2 maxChunk, int* requestBudget){
+    if(minChunk.x < 0) minChunk.x = 0;
+    if(minChunk.y < 0) minChunk.y = 0;
+    if(maxChunk.x > world->sizeInChunks.x - 1) maxChunk.x = world->sizeInChunks.x - 1;
+    if(maxChunk.y > world->sizeInChunks.y - 1) maxChunk.y = world->sizeInChunks.y - 1;
+    for(int y = minChunk.y; y <= maxChunk.y; y++){
+        for(int x = minChunk.x; x <= maxChunk.x; x++){
+            if(!request_chunk(world, {x, y}, requestBudget)) return false;
+        }
+    }
+    return true;
+}
+
+// Called once per frame on the main thread. Chunks under the camera are requested first, then a one chunk ring
+// around them, then the area the camera will cover in the next CHUNK_PREFETCH_SECONDS at its current velocity
+void update_chunk_streaming(ChunkWorld* world, TileRange visibleTiles, Vec2 cameraVelocityInTiles){
+    world->frame++;
+    int requestBudget = MAX_CHUNK_REQUESTS_PER_FRAME;
+
+    IVec2 minChunk = {visibleTiles.min.x >> CHUNK_SHIFT, visibleTiles.min.y >> CHUNK_SHIFT};
+    IVec2 maxChunk = {(visibleTiles.max.x - 1) >> CHUNK_SHIFT, (visibleTiles.max.y - 1) >> CHUNK_SHIFT};
+    if(!request_chunks(world, minChunk, maxChunk, &requestBudget)) return;
+    if(!request_chunks(world, {minChunk.x - 1, minChunk.y - 1}, {maxChunk.x + 1, maxChunk.y + 1}, &requestBudget)) return;
+
+    IVec2 prefetch = {(int)(cameraVelocityInTiles.x * CHUNK_PREFETCH_SECONDS) / CHUNK_SIZE,
+                      (int)(cameraVelocityInTiles.y * CHUNK_PREFETCH_SECONDS) / CHUNK_SIZE};
+    if(prefetch.x || prefetch.y){
+        request_chunks(world, {minChunk.x - 1 + (prefetch.x < 0 ? prefetch.x : 0), minChunk.y - 1 + (prefetch.y < 0 ? prefetch.y : 0)},
+                              {maxChunk.x + 1 + (prefetch.x > 0 ? prefetch.x : 0), maxChunk.y + 1 + (prefetch.y > 0 ? prefetch.y : 0)},
+                       &requestBudget);
+    }
+}
+
+// Main thread only. Hands out up to maxLoaded chunks that finished loading since the last call, each one once. Chunks
+// that were evicted again in the meantime are dropped
+int collect_loaded_chunks(ChunkWorld* world, IVec2* loaded, int maxLoaded){
+    int loadedCount = 0, keepCount = 0;
+    for(int idx = 0; idx < world->loadingChunks.count; idx++){
+        IVec2 chunkCoord = world->loadingChunks[idx];
+        int slot = find_chunk_slot(world, chunk_key(chunkCoord));
+        int state = slot >= 0 ? world->chunks[slot].state.load(std::memory_order_acquire) : CHUNK_FREE;
+        if(state == CHUNK_READY && loadedCount < maxLoaded) loaded[loadedCount++] = chunkCoord;
+        else if(state == CHUNK_LOADING || state == CHUNK_READY) world->loadingChunks[keepCount++] = chunkCoord;
+    }
+    world->loadingChunks.count = keepCount;
+    return loadedCount;
+}
+
+//#####################################################################################################################################
+//                                                  Chunk Loader (background thread)
+//#####################################################################################################################################
+bool read_spilled_chunk(ChunkWorld* world, IVec2 chunkCoord, Tile* tiles){
+    char path[320];
+    get_chunk_path(world, chunkCoord, path, sizeof(path));
+    auto file = fopen(path, "rb");
+    if(!file) return false;
+    bool result = fread(tiles, sizeof(Tile), CHUNK_TILE_COUNT, file) == CHUNK_TILE_COUNT;
+    fclose(file);
+    return result;
+}
+
+// The solid layer of a chunk as level file bits, from its spill file when it has one
+void read_chunk_solid_bits(ChunkWorld* world, IVec2 chunkCoord, bool spilled, unsigned char* bits){
+    Tile tiles[CHUNK_TILE_COUNT];
+    if(!spilled || !read_spilled_chunk(world, chunkCoord, tiles)){
+        read_level_chunk_layer(&world->level, chunkCoord, LEVEL_LAYER_SOLID, bits);
+        return;
+    }
+    memset(bits, 0, LEVEL_CHUNK_BITMAP_SIZE);
+    for(int idx = 0; idx < CHUNK_TILE_COUNT; idx++){
+        if(tiles[idx].isVisible) bits[idx >> 3] |= 1 << (idx & 7);
+    }
+}
+
+// Decodes the solid layer of the chunk and the 2 tile border around it, neighbour masks are derived from that. Bit
+// (dy + 1) * 3 + dx + 1 of spilledChunks reads that chunk of the 3x3 block from its spill file instead of the level.
+// Resident neighbours with newer edits are the main thread's business, see collect_loaded_chunks
+void decode_level_chunk(ChunkWorld* world, IVec2 chunkCoord, Tile* tiles, int spilledChunks = 0){
+    memset(tiles, 0, sizeof(Tile) * CHUNK_TILE_COUNT);
+    if(!(spilledChunks & BIT(4)) && !find_level_chunk(&world->level, chunkCoord)) return;
+
+    // The chunk itself first, an empty one needs none of its neighbours
+    unsigned char bits[3][3][LEVEL_CHUNK_BITMAP_SIZE];
+    read_chunk_solid_bits(world, chunkCoord, spilledChunks & BIT(4), bits[1][1]);
+    unsigned char anySolid = 0;
+    for(int idx = 0; idx < LEVEL_CHUNK_BITMAP_SIZE; idx++) anySolid |= bits[1][1][idx];
+    if(!anySolid) return;
+    for(int dy = -1; dy <= 1; dy++){
+        for(int dx = -1; dx <= 1; dx++){
+            if(!dx && !dy) continue;
+            read_chunk_solid_bits(world, {chunkCoord.x + dx, chunkCoord.y + dy}, spilledChunks & BIT((dy + 1) * 3 + dx + 1),
+                                  bits[dy + 1][dx + 1]);
+        }
+    }
+    // Expand into a byte grid with a 2 tile apron first, tiles outside the world count as solid
+    constexpr int APRON = 2;
+    constexpr int GRID_SIZE = CHUNK_SIZE + 2 * APRON;
+    unsigned char solid[GRID_SIZE * GRID_SIZE];
+    IVec2 origin = {chunkCoord.x * CHUNK_SIZE - APRON, chunkCoord.y * CHUNK_SIZE - APRON};
+    for(int y = 0; y < GRID_SIZE; y++){
+        int worldY = origin.y + y;
+        int localY = (y - APRON) & CHUNK_MASK;
+        unsigned char (*rowBits)[LEVEL_CHUNK_BITMAP_SIZE] = bits[floor_div(y - APRON, CHUNK_SIZE) + 1];
+        for(int x = 0; x < GRID_SIZE; x++){
+            int worldX = origin.x + x;
+            if(worldX < 0 || worldX >= world->sizeInTiles.x || worldY < 0 || worldY >= world->sizeInTiles.y){
+                solid[y * GRID_SIZE + x] = 1;
+                continue;
+            }
+            int bit = localY * CHUNK_SIZE + ((x - APRON) & CHUNK_MASK);
+            solid[y * GRID_SIZE + x] = (rowBits[floor_div(x - APRON, CHUNK_SIZE) + 1][bit >> 3] >> (bit & 7)) & 1;
+        }
+    }
+
+    int neighbourDeltas[12];
+    for(int n = 0; n < 12; n++) neighbourDeltas[n] = NEIGHBOUR_OFFSETS[n * 2 + 1] * GRID_SIZE + NEIGHBOUR_OFFSETS[n * 2];
+    for(int y = 0; y < CHUNK_SIZE; y++){
+        for(int x = 0; x < CHUNK_SIZE; x++){
+            unsigned char* cell = &solid[(y + APRON) * GRID_SIZE + x + APRON];
+            if(!*cell || origin.x + APRON + x >= world->sizeInTiles.x || origin.y + APRON + y >= world->sizeInTiles.y) continue;
+            int solidBits = 0;
+            for(int n = 0; n < 12; n++) solidBits |= cell[neighbourDeltas[n]] << n;
+            Tile* tile = &tiles[y * CHUNK_SIZE + x];
+            tile->isVisible = true;
+            tile->neigbourMask = neigbour_mask_from_solid(solidBits);
+        }
+    }
+}
+
+// Spilled chunks hold the latest edits, everything else comes from the level file. Masks are derived again for a
+// spilled chunk too, its neighbours may have changed since it was written
+void load_chunk_tiles(ChunkWorld* world, IVec2 chunkCoord, Tile* tiles, int spilledNeighbours = 0){
+    decode_level_chunk(world, chunkCoord, tiles, spilledNeighbours | BIT(4));
+}
+
+void save_chunk(ChunkWorld* world, Chunk* chunk){
+    char path[320];
+    get_chunk_path(world, chunk->coord, path, sizeof(path));
+    write_file(path, (char*)chunk->tiles, sizeof(chunk->tiles));
+    chunk->dirty = false;
+}
+
+void run_chunk_loader(ChunkWorld* world){
+    while(world->loaderRunning.load(std::memory_order_acquire)){
+        ChunkRequest request;
+        if(!pop_chunk_request(world, &request)){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        Chunk* chunk = &world->chunks[request.slot];
+        if(request.type == CHUNK_REQUEST_LOAD){
+            load_chunk_tiles(world, chunk->coord, chunk->tiles, request.spilledNeighbours);
+            chunk->state.store(CHUNK_READY, std::memory_order_release);
+        } else {
+            save_chunk(world, chunk);
+            chunk->state.store(CHUNK_FREE, std::memory_order_release);
+        }
+        world->completedRequests.fetch_add(1, std::memory_order_release);
+    }
+}
+
+// Main thread only, returns once every queued request has been handled
+void wait_for_chunk_loader(ChunkWorld* world){
+    int tail = world->queue.tail.load(std::memory_order_relaxed);
+    while(world->completedRequests.load(std::memory_order_acquire) != tail){
+        if(!world->loaderRunning.load(std::memory_order_acquire)) break;
+        std::this_thread::yield();
+    }
+}
+
+// Main thread only, after the loader thread has been joined. Fallback when the level itself could not be saved
+void flush_chunk_world(ChunkWorld* world){
+    for(int slot = 0; slot < world->chunkBudget; slot++){
+        Chunk* chunk = &world->chunks[slot];
+        int state = chunk->state.load(std::memory_order_acquire);
+        if((state == CHUNK_READY || state == CHUNK_SAVING) && chunk->dirty) save_chunk(world, chunk);
+    }
+}
+
+// Main thread only, while the loader is idle. An empty view keeps the current world size, resident chunks stay
+// valid since they hold decoded tiles
+void attach_level(ChunkWorld* world, LevelView level){
+    world->level = level;
+    if(!level.header) return;
+    world->sizeInTiles = level.header->sizeInTiles;
+    world->sizeInChunks = {(world->sizeInTiles.x + CHUNK_MASK) >> CHUNK_SHIFT, (world->sizeInTiles.y + CHUNK_MASK) >> CHUNK_SHIFT};
+}
+
+int compare_chunk_keys(const void* a, const void* b){
+    unsigned long long left = *(unsigned long long*)a, right = *(unsigned long long*)b;
+    return (left > right) - (left < right);
+}
+
+// Main thread only, while the loader is idle. Merges resident chunks, spilled chunks and the attached level into a
+// new level file, spill files are deleted once it is written. The caller swaps the new file in with attach_level
+bool write_chunk_world_level(ChunkWorld* world, char* path){
+    int maxKeys = (world->level.header ? world->level.header->chunkCount : 0) + world->spilledChunks.count + MAX_RESIDENT_CHUNKS;
+    unsigned long long* keys = (unsigned long long*)malloc(sizeof(unsigned long long) * maxKeys);
+    SM_ASSERT_GUARD(keys, false, "Failed to allocate %d chunk keys", maxKeys);
+
+    int keyCount = 0;
+    if(world->level.header){
+        for(int idx = 0; idx < world->level.header->chunkCount; idx++){
+            IVec2 coord = world->level.directory[idx].chunkCoord;
+            if(coord.x < world->sizeInChunks.x && coord.y < world->sizeInChunks.y) keys[keyCount++] = chunk_key(coord);
+        }
+    }
+    for(int idx = 0; idx < world->spilledChunks.count; idx++){
+        keys[keyCount++] = chunk_key(world->spilledChunks[idx]);
+    }
+    for(int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++){
+        if(world->chunks[slot].state.load(std::memory_order_acquire) == CHUNK_READY) keys[keyCount++] = chunk_key(world->chunks[slot].coord);
+    }
+    // Sorting the keys gives the (y, x) order the level directory needs
+    qsort(keys, keyCount, sizeof(unsigned long long), compare_chunk_keys);
+
+    LevelWriter writer;
+    if(!begin_level_file(&writer, path, world->sizeInTiles)){
+        free(keys);
+        return false;
+    }
+
+    Tile tiles[CHUNK_TILE_COUNT];
+    unsigned char layerBits[LEVEL_LAYER_COUNT * LEVEL_CHUNK_BITMAP_SIZE];
+    for(int idx = 0; idx < keyCount; idx++){
+        if(idx > 0 && keys[idx] == keys[idx - 1]) continue;
+        IVec2 coord = chunk_key_coord(keys[idx]);
+
+        Chunk* chunk = get_chunk(world, coord);
+        if(chunk) memcpy(tiles, chunk->tiles, sizeof(tiles));
+        else load_chunk_tiles(world, coord, tiles);
+
+        memset(layerBits, 0, sizeof(layerBits));
+        bool empty = true;
+        for(int tileIdx = 0; tileIdx < CHUNK_TILE_COUNT; tileIdx++){
+            if(!tiles[tileIdx].isVisible) continue;
+            layerBits[LEVEL_LAYER_SOLID * LEVEL_CHUNK_BITMAP_SIZE + (tileIdx >> 3)] |= 1 << (tileIdx & 7);
+            empty = false;
+        }
+        if(!empty) add_level_chunk(&writer, coord, layerBits);
+    }
+    free(keys);
+    if(!end_level_file(&writer)) return false;
+
+    char spillPath[320];
+    for(int idx = 0; idx < world->spilledChunks.count; idx++){
+        get_chunk_path(world, world->spilledChunks[idx], spillPath, sizeof(spillPath));
+        remove(spillPath);
+    }
+    world->spilledChunks.clear();
+    for(int slot = 0; slot < MAX_RESIDENT_CHUNKS; slot++){
+        world->chunks[slot].dirty = false;
+    }
+    return true;
+}
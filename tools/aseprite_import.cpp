@@ -0,0 +1,332 @@
+#include "../src/engine_lib.h"
+
+//#####################################################################################################################################
+//                                                  Importer Constants
+//#####################################################################################################################################
+constexpr unsigned short ASEPRITE_MAGIC = 0xA5E0;
+constexpr unsigned short ASEPRITE_FRAME_MAGIC = 0xF1FA;
+constexpr unsigned short ASEPRITE_CHUNK_TAGS = 0x2018;
+constexpr unsigned short ASEPRITE_CHUNK_SLICE = 0x2022;
+constexpr int ASEPRITE_HEADER_SIZE = 128;
+constexpr int ASEPRITE_FRAME_HEADER_SIZE = 16;
+
+constexpr int MAX_IMPORT_FRAMES = 1024;
+constexpr int MAX_IMPORT_TAGS = 256;
+constexpr int MAX_IMPORT_SLICES = 256;
+constexpr int MAX_IMPORT_SLICE_KEYS = 64;
+constexpr int MAX_IMPORT_NAME = 64;
+constexpr int MAX_IMPORT_TICKS = 1 << 16;
+
+//#####################################################################################################################################
+//                                                  Importer Structs
+//#####################################################################################################################################
+enum AsepriteDirection{
+    ASEPRITE_FORWARD,
+    ASEPRITE_REVERSE,
+    ASEPRITE_PING_PONG,
+    ASEPRITE_PING_PONG_REVERSE,
+};
+
+struct AsepriteTag{
+    char name[MAX_IMPORT_NAME];
+    int from, to;
+    int direction;
+    int repeat;                 // 0 loops forever
+};
+
+struct AsepriteSliceKey{
+    int frame;                  // the key holds from this frame until the next key
+    IVec2 pos;
+    IVec2 size;
+};
+
+struct AsepriteSlice{
+    char name[MAX_IMPORT_NAME];
+    Array<AsepriteSliceKey, MAX_IMPORT_SLICE_KEYS> keys;
+};
+
+struct AsepriteFile{
+    IVec2 size;
+    Array<int, MAX_IMPORT_FRAMES> durations;    // milliseconds per frame
+    Array<AsepriteTag, MAX_IMPORT_TAGS> tags;
+    Array<AsepriteSlice, MAX_IMPORT_SLICES> slices;
+};
+
+// Little endian cursor, reads past the end return 0 and set failed instead of touching memory
+struct ByteReader{
+    unsigned char* data;
+    int size;
+    int offset;
+    bool failed;
+};
+
+//#####################################################################################################################################
+//                                                  Importer Utility
+//#####################################################################################################################################
+unsigned int read_bytes(ByteReader* reader, int count){
+    if(reader->offset + count > reader->size){
+        reader->failed = true;
+        reader->offset = reader->size;
+        return 0;
+    }
+    unsigned int value = 0;
+    for(int idx = 0; idx < count; idx++) value |= (unsigned int)reader->data[reader->offset + idx] << (idx * 8);
+    reader->offset += count;
+    return value;
+}
+
+unsigned int read_u8(ByteReader* reader){ return read_bytes(reader, 1); }
+unsigned int read_u16(ByteReader* reader){ return read_bytes(reader, 2); }
+unsigned int read_u32(ByteReader* reader){ return read_bytes(reader, 4); }
+int read_i32(ByteReader* reader){ return (int)read_bytes(reader, 4); }
+
+void skip_bytes(ByteReader* reader, int count){
+    if(reader->offset + count > reader->size) reader->failed = true;
+    reader->offset = reader->offset + count > reader->size ? reader->size : reader->offset + count;
+}
+
+// Aseprite STRING: WORD length followed by that many bytes, truncated to fit name
+void read_string(ByteReader* reader, char* name, int capacity){
+    int length = (int)read_u16(reader);
+    int copied = length < capacity - 1 ? length : capacity - 1;
+    if(reader->offset + length > reader->size){
+        reader->failed = true;
+        copied = 0;
+    }
+    memcpy(name, reader->data + reader->offset, copied);
+    name[copied] = 0;
+    skip_bytes(reader, length);
+}
+
+int gcd(int a, int b){
+    while(b){
+        int rest = a % b;
+        a = b;
+        b = rest;
+    }
+    return a;
+}
+
+// "dice_roll" -> "DICE_ROLL", anything that can not be part of an identifier becomes '_'
+void make_identifier(char* name, char* identifier, int capacity){
+    int idx = 0;
+    for(; name[idx] && idx < capacity - 1; idx++){
+        char c = name[idx];
+        if(c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+        bool valid = (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+        identifier[idx] = valid ? c : '_';
+    }
+    identifier[idx] = 0;
+}
+
+AsepriteSlice* find_slice(AsepriteFile* file, char* name){
+    for(int idx = 0; idx < file->slices.count; idx++){
+        if(strcmp(file->slices[idx].name, name) == 0) return &file->slices[idx];
+    }
+    return nullptr;
+}
+
+AsepriteSliceKey get_slice_key(AsepriteSlice* slice, int frame){
+    AsepriteSliceKey key = slice->keys[0];
+    for(int idx = 1; idx < slice->keys.count; idx++){
+        if(slice->keys[idx].frame <= frame) key = slice->keys[idx];
+    }
+    return key;
+}
+
+//#####################################################################################################################################
+//                                                  Importer Functions
+//#####################################################################################################################################
+// Only frame durations, tags and slices are read, pixels come from the exported png
+bool parse_aseprite(char* data, int size, AsepriteFile* file){
+    ByteReader reader = {(unsigned char*)data, size};
+    read_u32(&reader);
+    SM_ASSERT_GUARD(read_u16(&reader) == ASEPRITE_MAGIC, false, "Not an Aseprite file");
+    int frameCount = (int)read_u16(&reader);
+    file->size.x = (int)read_u16(&reader);
+    file->size.y = (int)read_u16(&reader);
+    SM_ASSERT_GUARD(frameCount <= MAX_IMPORT_FRAMES, false, "Too many frames: %d", frameCount);
+
+    int frameOffset = ASEPRITE_HEADER_SIZE;
+    for(int frame = 0; frame < frameCount; frame++){
+        reader.offset = frameOffset;
+        int frameSize = (int)read_u32(&reader);
+        SM_ASSERT_GUARD(read_u16(&reader) == ASEPRITE_FRAME_MAGIC, false, "Frame %d is corrupt", frame);
+        int chunkCount = (int)read_u16(&reader);
+        file->durations.add((int)read_u16(&reader));
+        skip_bytes(&reader, 2);
+        int newChunkCount = (int)read_u32(&reader);
+        if(newChunkCount) chunkCount = newChunkCount;
+
+        int chunkOffset = frameOffset + ASEPRITE_FRAME_HEADER_SIZE;
+        for(int chunk = 0; chunk < chunkCount && !reader.failed; chunk++){
+            reader.offset = chunkOffset;
+            int chunkSize = (int)read_u32(&reader);
+            int chunkType = (int)read_u16(&reader);
+            SM_ASSERT_GUARD(chunkSize >= 6, false, "Chunk %d of frame %d is corrupt", chunk, frame);
+
+            if(chunkType == ASEPRITE_CHUNK_TAGS){
+                int tagCount = (int)read_u16(&reader);
+                skip_bytes(&reader, 8);
+                for(int idx = 0; idx < tagCount; idx++){
+                    SM_ASSERT_GUARD(!file->tags.is_full(), false, "Too many tags");
+                    AsepriteTag tag = {};
+                    tag.from = (int)read_u16(&reader);
+                    tag.to = (int)read_u16(&reader);
+                    tag.direction = (int)read_u8(&reader);
+                    tag.repeat = (int)read_u16(&reader);
+                    skip_bytes(&reader, 6 + 3 + 1);
+                    read_string(&reader, tag.name, MAX_IMPORT_NAME);
+                    file->tags.add(tag);
+                }
+            }
+
+            if(chunkType == ASEPRITE_CHUNK_SLICE){
+                SM_ASSERT_GUARD(!file->slices.is_full(), false, "Too many slices");
+                AsepriteSlice* slice = &file->slices.elements[file->slices.count++];
+                *slice = {};
+                int keyCount = (int)read_u32(&reader);
+                int flags = (int)read_u32(&reader);
+                skip_bytes(&reader, 4);
+                read_string(&reader, slice->name, MAX_IMPORT_NAME);
+                for(int idx = 0; idx < keyCount; idx++){
+                    SM_ASSERT_GUARD(!slice->keys.is_full(), false, "Slice %s has too many keys", slice->name);
+                    AsepriteSliceKey key = {};
+                    key.frame = (int)read_u32(&reader);
+                    key.pos.x = read_i32(&reader);
+                    key.pos.y = read_i32(&reader);
+                    key.size.x = (int)read_u32(&reader);
+                    key.size.y = (int)read_u32(&reader);
+                    if(flags & 1) skip_bytes(&reader, 16);      // 9 patch center
+                    if(flags & 2) skip_bytes(&reader, 8);       // pivot
+                    slice->keys.add(key);
+                }
+                SM_ASSERT_GUARD(slice->keys.count > 0, false, "Slice %s has no keys", slice->name);
+            }
+            chunkOffset += chunkSize;
+        }
+        SM_ASSERT_GUARD(!reader.failed, false, "Frame %d is truncated", frame);
+        frameOffset += frameSize;
+    }
+    return true;
+}
+
+// Frames in the order the tag plays them, ping pong does not repeat the turning frames
+int get_tag_sequence(AsepriteTag* tag, int* sequence){
+    int count = 0;
+    int length = tag->to - tag->from + 1;
+    for(int idx = 0; idx < length; idx++){
+        sequence[count++] = tag->direction == ASEPRITE_REVERSE || tag->direction == ASEPRITE_PING_PONG_REVERSE ?
+                            tag->to - idx : tag->from + idx;
+    }
+    if(tag->direction == ASEPRITE_PING_PONG || tag->direction == ASEPRITE_PING_PONG_REVERSE){
+        for(int idx = length - 2; idx > 0; idx--) sequence[count++] = sequence[idx];
+    }
+    return count;
+}
+
+bool write_assets_header(AsepriteFile* file, const char* sourcePath, FILE* out){
+    char identifier[MAX_IMPORT_NAME];
+
+    fprintf(out, "#pragma once\n");
+    fprintf(out, "// Generated by tools/aseprite_import.cpp from %s, edit the slices and tags there instead\n\n", sourcePath);
+
+    fprintf(out, "enum SpriteID{\n");
+    for(int idx = 0; idx < file->slices.count; idx++){
+        make_identifier(file->slices[idx].name, identifier, MAX_IMPORT_NAME);
+        fprintf(out, "    SPRITE_%s,\n", identifier);
+    }
+    fprintf(out, "\n    SPRITE_COUNT\n};\n\n");
+
+    fprintf(out, "enum AnimationID{\n");
+    for(int idx = 0; idx < file->tags.count; idx++){
+        make_identifier(file->tags[idx].name, identifier, MAX_IMPORT_NAME);
+        fprintf(out, "    ANIMATION_%s,\n", identifier);
+    }
+    fprintf(out, "\n    ANIMATION_COUNT\n};\n\n");
+
+    fprintf(out, "constexpr Sprite SPRITES[(SPRITE_COUNT > 0 ? SPRITE_COUNT : 1)] = {\n");
+    for(int idx = 0; idx < file->slices.count; idx++){
+        AsepriteSliceKey key = get_slice_key(&file->slices[idx], 0);
+        fprintf(out, "    {{%d, %d}, {%d, %d}, 0},      // %s\n", key.pos.x, key.pos.y, key.size.x, key.size.y, file->slices[idx].name);
+    }
+    fprintf(out, "};\n\n");
+
+    // Every tag becomes its frames in playback order plus a tick table at the gcd of their durations, so finding
+    // the frame for a point in time is one division and one lookup
+    static int sequences[MAX_IMPORT_TAGS][MAX_IMPORT_FRAMES * 2];
+    int sequenceCounts[MAX_IMPORT_TAGS];
+    int tickCount = 0;
+    fprintf(out, "constexpr AnimationFrame ANIMATION_FRAMES[] = {\n");
+    for(int idx = 0; idx < file->tags.count; idx++){
+        AsepriteTag* tag = &file->tags[idx];
+        AsepriteSlice* slice = find_slice(file, tag->name);
+        SM_ASSERT_GUARD(slice, false, "Tag %s has no slice of the same name", tag->name);
+        SM_ASSERT_GUARD(tag->from <= tag->to && tag->to < file->durations.count, false, "Tag %s is out of range", tag->name);
+        sequenceCounts[idx] = get_tag_sequence(tag, sequences[idx]);
+        for(int frame = 0; frame < sequenceCounts[idx]; frame++){
+            AsepriteSliceKey key = get_slice_key(slice, sequences[idx][frame]);
+            fprintf(out, "    {{%d, %d}, {%d, %d}, 0},      // %s %d\n", key.pos.x, key.pos.y, key.size.x, key.size.y,
+                    tag->name, sequences[idx][frame]);
+        }
+    }
+    if(!file->tags.count) fprintf(out, "    {},\n");
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "constexpr unsigned short ANIMATION_TICKS[] = {");
+    int firstFrame = 0;
+    int firstTicks[MAX_IMPORT_TAGS], tickCounts[MAX_IMPORT_TAGS], tickMs[MAX_IMPORT_TAGS];
+    for(int idx = 0; idx < file->tags.count; idx++){
+        tickMs[idx] = 0;
+        for(int frame = 0; frame < sequenceCounts[idx]; frame++) tickMs[idx] = gcd(tickMs[idx], file->durations[sequences[idx][frame]]);
+        if(tickMs[idx] <= 0) tickMs[idx] = 1;
+        firstTicks[idx] = tickCount;
+        fprintf(out, "\n   ");
+        for(int frame = 0; frame < sequenceCounts[idx]; frame++){
+            int ticks = file->durations[sequences[idx][frame]] / tickMs[idx];
+            SM_ASSERT_GUARD(tickCount + ticks <= MAX_IMPORT_TICKS, false, "Tag %s needs too many ticks", file->tags[idx].name);
+            for(int tick = 0; tick < ticks; tick++) fprintf(out, " %d,", firstFrame + frame);
+            tickCount += ticks;
+        }
+        tickCounts[idx] = tickCount - firstTicks[idx];
+        SM_ASSERT_GUARD(tickCounts[idx] > 0, false, "Tag %s has no frame with a duration", file->tags[idx].name);
+        firstFrame += sequenceCounts[idx];
+    }
+    fprintf(out, tickCount ? "\n};\n\n" : " 0 };\n\n");
+
+    fprintf(out, "constexpr Animation ANIMATIONS[(ANIMATION_COUNT > 0 ? ANIMATION_COUNT : 1)] = {\n");
+    for(int idx = 0; idx < file->tags.count; idx++){
+        AsepriteTag* tag = &file->tags[idx];
+        // Repeat counts above one are rounded to playing once and holding the last frame
+        fprintf(out, "    {%d, %d, %.6ff, %.6ff, %s},      // %s\n", firstTicks[idx], tickCounts[idx], 1000.0f / tickMs[idx],
+                tickCounts[idx] * tickMs[idx] / 1000.0f, tag->repeat == 0 ? "true" : "false", tag->name);
+    }
+    fprintf(out, "};\n");
+    return true;
+}
+
+//#####################################################################################################################################
+//                                                  Importer Main
+//#####################################################################################################################################
+// aseprite_import.exe [source.aseprite] [output.h]
+// Every slice becomes a SpriteID with the rect of its first key. Every tag becomes an AnimationID and has to come with
+// a slice of the same name, whose keys give the atlas rect of each frame of the tag.
+int main(int argc, char** argv){
+    const char* sourcePath = argc > 1 ? argv[1] : "assets/textures/Texture_Atlas.aseprite";
+    const char* outputPath = argc > 2 ? argv[2] : "src/assets_generated.h";
+
+    BumpAllocator storage = make_bump_allocator(MB(16) + sizeof(AsepriteFile));
+    AsepriteFile* file = (AsepriteFile*)bump_alloc(&storage, sizeof(AsepriteFile));
+    long fileSize = get_file_size(sourcePath);
+    SM_ASSERT_GUARD(fileSize > 0 && fileSize <= (long)MB(16), -1, "Failed to read %s", sourcePath);
+    int size = 0;
+    char* data = read_file(sourcePath, &size, &storage);
+    SM_ASSERT_GUARD(data, -1, "Failed to read %s", sourcePath);
+
+    if(!parse_aseprite(data, size, file)) return -1;
+    FILE* out = begin_file_replace(outputPath);
+    if(!out) return -1;
+    if(!finish_file_replace(out, outputPath, write_assets_header(file, sourcePath, out))) return -1;
+    SM_TRACE("%s: %d sprites, %d animations -> %s", sourcePath, file->slices.count, file->tags.count, outputPath);
+    return 0;
+}
@@ -0,0 +1,371 @@
+#include "../src/engine_lib.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+//#####################################################################################################################################
+//                                                  Packer Constants
+//#####################################################################################################################################
+constexpr int MAX_PACK_SPRITES = 1024;
+constexpr int MAX_PACK_PAGES = 32;
+constexpr int MAX_PACK_FREE_RECTS = 4096;
+constexpr int MAX_PACK_NAME = 64;
+constexpr int MAX_PACK_PATH = 256;
+constexpr int PACK_PADDING = 1;                 // transparent texels right and below every sprite
+
+//#####################################################################################################################################
+//                                                  Packer Structs
+//#####################################################################################################################################
+struct PackRect{
+    IVec2 pos;
+    IVec2 size;
+};
+
+struct PackSprite{
+    char name[MAX_PACK_NAME];
+    char* path;
+    IVec2 size;
+    unsigned int* texels;
+    int page;
+    IVec2 pos;
+};
+
+// MaxRects keeps every maximal free rectangle of the page, they overlap each other
+struct PackPage{
+    IVec2 usedSize;             // bounds of the placed sprites, the page is cropped to it
+    Array<PackRect, MAX_PACK_FREE_RECTS> freeRects;
+};
+
+struct Packer{
+    int pageSize;
+    Array<PackSprite, MAX_PACK_SPRITES> sprites;
+    Array<PackPage, MAX_PACK_PAGES> pages;
+};
+
+//#####################################################################################################################################
+//                                                  Packer Utility
+//#####################################################################################################################################
+// "assets/textures/sprites/rewind.png" -> "REWIND", anything that can not be part of an identifier becomes '_'
+void make_sprite_identifier(char* path, char* identifier, int capacity){
+    char* name = path;
+    for(char* cursor = path; *cursor; cursor++){
+        if(*cursor == '/' || *cursor == '\\') name = cursor + 1;
+    }
+    int length = 0;
+    for(; name[length] && name[length] != '.' && length < capacity - 1; length++){
+        char c = name[length];
+        if(c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        identifier[length] = (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ? c : '_';
+    }
+    identifier[length] = 0;
+}
+
+bool contains_rect(PackRect outer, PackRect inner){
+    return inner.pos.x >= outer.pos.x && inner.pos.y >= outer.pos.y &&
+           inner.pos.x + inner.size.x <= outer.pos.x + outer.size.x &&
+           inner.pos.y + inner.size.y <= outer.pos.y + outer.size.y;
+}
+
+// Best short side fit, the free rect that leaves the smallest leftover along its tighter side
+bool find_free_rect(PackPage* page, IVec2 size, PackRect* result, int* score){
+    bool found = false;
+    for(int idx = 0; idx < page->freeRects.count; idx++){
+        PackRect freeRect = page->freeRects[idx];
+        if(freeRect.size.x < size.x || freeRect.size.y < size.y) continue;
+        int shortSide = min(freeRect.size.x - size.x, freeRect.size.y - size.y);
+        if(!found || shortSide < *score){
+            *result = {freeRect.pos, size};
+            *score = shortSide;
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Every free rect overlapping placed is replaced by the up to four maximal rects left around it, then rects
+// contained in another one are dropped
+bool place_rect(PackPage* page, PackRect placed){
+    static PackRect splits[MAX_PACK_FREE_RECTS];
+    int splitCount = 0;
+    int keptCount = 0;
+    for(int idx = 0; idx < page->freeRects.count; idx++){
+        PackRect freeRect = page->freeRects[idx];
+        if(placed.pos.x >= freeRect.pos.x + freeRect.size.x || placed.pos.x + placed.size.x <= freeRect.pos.x ||
+           placed.pos.y >= freeRect.pos.y + freeRect.size.y || placed.pos.y + placed.size.y <= freeRect.pos.y){
+            page->freeRects.elements[keptCount++] = freeRect;
+            continue;
+        }
+        SM_ASSERT_GUARD(splitCount + 4 <= MAX_PACK_FREE_RECTS, false, "Page ran out of free rects");
+        if(placed.pos.x > freeRect.pos.x){
+            splits[splitCount++] = {freeRect.pos, {placed.pos.x - freeRect.pos.x, freeRect.size.y}};
+        }
+        if(placed.pos.x + placed.size.x < freeRect.pos.x + freeRect.size.x){
+            int x = placed.pos.x + placed.size.x;
+            splits[splitCount++] = {{x, freeRect.pos.y}, {freeRect.pos.x + freeRect.size.x - x, freeRect.size.y}};
+        }
+        if(placed.pos.y > freeRect.pos.y){
+            splits[splitCount++] = {freeRect.pos, {freeRect.size.x, placed.pos.y - freeRect.pos.y}};
+        }
+        if(placed.pos.y + placed.size.y < freeRect.pos.y + freeRect.size.y){
+            int y = placed.pos.y + placed.size.y;
+            splits[splitCount++] = {{freeRect.pos.x, y}, {freeRect.size.x, freeRect.pos.y + freeRect.size.y - y}};
+        }
+    }
+    SM_ASSERT_GUARD(keptCount + splitCount <= MAX_PACK_FREE_RECTS, false, "Page ran out of free rects");
+    page->freeRects.count = keptCount;
+    for(int idx = 0; idx < splitCount; idx++) page->freeRects.add(splits[idx]);
+
+    for(int idx = 0; idx < page->freeRects.count; idx++){
+        for(int other = idx + 1; other < page->freeRects.count; other++){
+            if(contains_rect(page->freeRects[other], page->freeRects[idx])){
+                page->freeRects.elements[idx--] = page->freeRects.elements[--page->freeRects.count];
+                break;
+            }
+            if(contains_rect(page->freeRects[idx], page->freeRects[other])){
+                page->freeRects.elements[other--] = page->freeRects.elements[--page->freeRects.count];
+            }
+        }
+    }
+
+    page->usedSize.x = max(page->usedSize.x, placed.pos.x + placed.size.x);
+    page->usedSize.y = max(page->usedSize.y, placed.pos.y + placed.size.y);
+    return true;
+}
+
+// Sprites go in largest first, each onto the page where it fits best, a new page is opened when none has room
+bool pack_sprites(Packer* packer){
+    PackSprite* sprites = packer->sprites.elements;
+    for(int idx = 1; idx < packer->sprites.count; idx++){
+        PackSprite sprite = sprites[idx];
+        int area = sprite.size.x * sprite.size.y;
+        int other = idx;
+        for(; other > 0 && sprites[other - 1].size.x * sprites[other - 1].size.y < area; other--) sprites[other] = sprites[other - 1];
+        sprites[other] = sprite;
+    }
+
+    for(int idx = 0; idx < packer->sprites.count; idx++){
+        PackSprite* sprite = &sprites[idx];
+        IVec2 paddedSize = {sprite->size.x + PACK_PADDING, sprite->size.y + PACK_PADDING};
+        SM_ASSERT_GUARD(paddedSize.x <= packer->pageSize && paddedSize.y <= packer->pageSize, false,
+                        "%s (%dx%d) does not fit a %d page", sprite->name, sprite->size.x, sprite->size.y, packer->pageSize);
+
+        int bestPage = -1, bestScore = 0;
+        PackRect bestRect = {};
+        for(int pageIdx = 0; pageIdx < packer->pages.count; pageIdx++){
+            PackRect rect;
+            int score;
+            if(find_free_rect(&packer->pages[pageIdx], paddedSize, &rect, &score) && (bestPage < 0 || score < bestScore)){
+                bestPage = pageIdx;
+                bestScore = score;
+                bestRect = rect;
+            }
+        }
+        if(bestPage < 0){
+            SM_ASSERT_GUARD(packer->pages.count < MAX_PACK_PAGES, false, "More than %d pages needed", MAX_PACK_PAGES);
+            PackPage* page = &packer->pages.elements[packer->pages.count++];
+            page->usedSize = {};
+            page->freeRects.clear();
+            page->freeRects.add({{0, 0}, {packer->pageSize, packer->pageSize}});
+            bestPage = packer->pages.count - 1;
+            find_free_rect(page, paddedSize, &bestRect, &bestScore);
+        }
+        if(!place_rect(&packer->pages[bestPage], bestRect)) return false;
+        sprite->page = bestPage;
+        sprite->pos = bestRect.pos;
+    }
+    return true;
+}
+
+//#####################################################################################################################################
+//                                                  PNG Writer
+//#####################################################################################################################################
+unsigned int crc32(unsigned int crc, unsigned char* data, int size){
+    static unsigned int table[256];
+    if(!table[1]){
+        for(unsigned int idx = 0; idx < 256; idx++){
+            unsigned int value = idx;
+            for(int bit = 0; bit < 8; bit++) value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            table[idx] = value;
+        }
+    }
+    crc = ~crc;
+    for(int idx = 0; idx < size; idx++) crc = table[(crc ^ data[idx]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void write_u32_be(FILE* out, unsigned int value){
+    unsigned char bytes[4] = {(unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value};
+    fwrite(bytes, 1, 4, out);
+}
+
+void write_png_chunk(FILE* out, const char* type, unsigned char* data, int size){
+    write_u32_be(out, size);
+    fwrite(type, 1, 4, out);
+    if(size) fwrite(data, 1, size, out);
+    write_u32_be(out, crc32(crc32(0, (unsigned char*)type, 4), data, size));
+}
+
+// RGBA8 with stored (uncompressed) deflate blocks, the pages only hold a handful of small sprites
+bool write_png(char* path, unsigned int* texels, IVec2 size, BumpAllocator* storage){
+    int rowSize = 1 + size.x * 4;
+    int rawSize = rowSize * size.y;
+    int blockCount = (rawSize + 65534) / 65535;
+    unsigned char* idat = (unsigned char*)bump_alloc(storage, 2 + rawSize + blockCount * 5 + 4);
+    SM_ASSERT_GUARD(idat, false, "Not enough memory to write %s", path);
+
+    unsigned char* raw = (unsigned char*)bump_alloc(storage, rawSize);
+    SM_ASSERT_GUARD(raw, false, "Not enough memory to write %s", path);
+    for(int y = 0; y < size.y; y++){
+        raw[y * rowSize] = 0;
+        memcpy(raw + y * rowSize + 1, texels + y * size.x, size.x * 4);
+    }
+
+    int cursor = 0;
+    idat[cursor++] = 0x78;
+    idat[cursor++] = 0x01;
+    unsigned int adlerA = 1, adlerB = 0;
+    for(int offset = 0; offset < rawSize; offset += 65535){
+        int blockSize = min(rawSize - offset, 65535);
+        idat[cursor++] = offset + blockSize == rawSize;
+        idat[cursor++] = blockSize & 0xFF;
+        idat[cursor++] = blockSize >> 8;
+        idat[cursor++] = ~blockSize & 0xFF;
+        idat[cursor++] = (~blockSize >> 8) & 0xFF;
+        memcpy(idat + cursor, raw + offset, blockSize);
+        cursor += blockSize;
+        for(int idx = 0; idx < blockSize; idx++){
+            adlerA = (adlerA + raw[offset + idx]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+    }
+    unsigned int adler = adlerB << 16 | adlerA;
+    for(int shift = 24; shift >= 0; shift -= 8) idat[cursor++] = (unsigned char)(adler >> shift);
+
+    FILE* out = begin_file_replace(path);
+    if(!out) return false;
+    unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, 8, out);
+    unsigned char header[13] = {(unsigned char)(size.x >> 24), (unsigned char)(size.x >> 16), (unsigned char)(size.x >> 8), (unsigned char)size.x,
+                                (unsigned char)(size.y >> 24), (unsigned char)(size.y >> 16), (unsigned char)(size.y >> 8), (unsigned char)size.y,
+                                8, 6, 0, 0, 0};
+    write_png_chunk(out, "IHDR", header, 13);
+    write_png_chunk(out, "IDAT", idat, cursor);
+    write_png_chunk(out, "IEND", nullptr, 0);
+    return finish_file_replace(out, path, true);
+}
+
+//#####################################################################################################################################
+//                                                  Packer Functions
+//#####################################################################################################################################
+bool write_pages(Packer* packer, char* pagePrefix, BumpAllocator* storage){
+    for(int pageIdx = 0; pageIdx < packer->pages.count; pageIdx++){
+        IVec2 size = packer->pages[pageIdx].usedSize;
+        unsigned int* texels = (unsigned int*)bump_alloc(storage, sizeof(unsigned int) * size.x * size.y);
+        SM_ASSERT_GUARD(texels, false, "Not enough memory for page %d", pageIdx);
+        memset(texels, 0, sizeof(unsigned int) * size.x * size.y);
+        for(int idx = 0; idx < packer->sprites.count; idx++){
+            PackSprite* sprite = &packer->sprites[idx];
+            if(sprite->page != pageIdx) continue;
+            for(int y = 0; y < sprite->size.y; y++){
+                memcpy(texels + (sprite->pos.y + y) * size.x + sprite->pos.x, sprite->texels + y * sprite->size.x, sprite->size.x * 4);
+            }
+        }
+        char path[MAX_PACK_PATH];
+        snprintf(path, sizeof(path), "%s%d.png", pagePrefix, pageIdx + 1);
+        if(!write_png(path, texels, size, storage)) return false;
+    }
+    return true;
+}
+
+// Pages left over from a run that needed more of them, only removed once the header no longer lists them
+void remove_stale_pages(Packer* packer, char* pagePrefix){
+    for(int pageIdx = packer->pages.count; pageIdx < MAX_PACK_PAGES; pageIdx++){
+        char path[MAX_PACK_PATH];
+        snprintf(path, sizeof(path), "%s%d.png", pagePrefix, pageIdx + 1);
+        if(!file_exists(path)) continue;
+        if(remove(path) != 0){
+            SM_WARN("Failed removing stale page %s", path);
+            continue;
+        }
+        SM_TRACE("Removed stale page %s", path);
+    }
+}
+
+// Page 0 is the base atlas, the packed pages follow it in the order they were written
+bool write_atlas_header(Packer* packer, char* baseAtlasPath, char* pagePrefix, FILE* out){
+    fprintf(out, "#pragma once\n");
+    fprintf(out, "// Generated by tools/atlas_pack.cpp, add or change the images in assets/textures/sprites instead\n\n");
+
+    fprintf(out, "constexpr int ATLAS_PAGE_COUNT = %d;\n\n", packer->pages.count + 1);
+    fprintf(out, "constexpr const char* ATLAS_PAGES[ATLAS_PAGE_COUNT] = {\n");
+    fprintf(out, "    \"%s\",\n", baseAtlasPath);
+    for(int pageIdx = 0; pageIdx < packer->pages.count; pageIdx++) fprintf(out, "    \"%s%d.png\",\n", pagePrefix, pageIdx + 1);
+    fprintf(out, "};\n\n");
+
+    // Sorted by name, so adding an image does not renumber the others
+    int order[MAX_PACK_SPRITES];
+    for(int idx = 0; idx < packer->sprites.count; idx++){
+        int other = idx;
+        for(; other > 0 && strcmp(packer->sprites[order[other - 1]].name, packer->sprites[idx].name) > 0; other--) order[other] = order[other - 1];
+        order[other] = idx;
+    }
+
+    fprintf(out, "enum PackedSpriteID{\n");
+    for(int idx = 0; idx < packer->sprites.count; idx++) fprintf(out, "    PACKED_SPRITE_%s,\n", packer->sprites[order[idx]].name);
+    fprintf(out, "\n    PACKED_SPRITE_COUNT\n};\n\n");
+
+    fprintf(out, "constexpr Sprite PACKED_SPRITES[(PACKED_SPRITE_COUNT > 0 ? PACKED_SPRITE_COUNT : 1)] = {\n");
+    for(int idx = 0; idx < packer->sprites.count; idx++){
+        PackSprite* sprite = &packer->sprites[order[idx]];
+        fprintf(out, "    {{%d, %d}, {%d, %d}, %d},      // %s\n", sprite->pos.x, sprite->pos.y, sprite->size.x, sprite->size.y,
+                sprite->page + 1, sprite->name);
+    }
+    fprintf(out, "};\n");
+    return true;
+}
+
+//#####################################################################################################################################
+//                                                  Packer Main
+//#####################################################################################################################################
+// atlas_pack.exe output.h pagePrefix pageSize baseAtlas.png [sprite.png ...]
+// Every image becomes a PackedSpriteID named after its file and is packed with MaxRects onto pages of at most
+// pageSize x pageSize, written as <pagePrefix><n>.png. The base atlas is not touched, it stays page 0.
+int main(int argc, char** argv){
+    SM_ASSERT_GUARD(argc >= 5, -1, "Usage: atlas_pack.exe output.h pagePrefix pageSize baseAtlas.png [sprite.png ...]");
+    char* outputPath = argv[1];
+    char* pagePrefix = argv[2];
+    char* baseAtlasPath = argv[4];
+
+    BumpAllocator storage = make_bump_allocator(MB(64) + sizeof(Packer));
+    Packer* packer = (Packer*)bump_alloc(&storage, sizeof(Packer));
+    SM_ASSERT_GUARD(packer, -1, "Failed to allocate Packer");
+    packer->pageSize = atoi(argv[3]);
+    SM_ASSERT_GUARD(packer->pageSize > 0, -1, "Invalid page size %s", argv[3]);
+
+    for(int arg = 5; arg < argc; arg++){
+        // An unmatched shell glob is passed through as is
+        SM_ASSERT_GUARD(!strchr(argv[arg], '*') || file_exists(argv[arg]), -1,
+                        "No images match %s, pass no sprite arguments to pack none", argv[arg]);
+        SM_ASSERT_GUARD(packer->sprites.count < MAX_PACK_SPRITES, -1, "More than %d sprites", MAX_PACK_SPRITES);
+        PackSprite sprite = {};
+        sprite.path = argv[arg];
+        make_sprite_identifier(argv[arg], sprite.name, MAX_PACK_NAME);
+        for(int idx = 0; idx < packer->sprites.count; idx++){
+            SM_ASSERT_GUARD(strcmp(packer->sprites[idx].name, sprite.name), -1, "%s and %s both become PACKED_SPRITE_%s",
+                            packer->sprites[idx].path, sprite.path, sprite.name);
+        }
+        int channels;
+        sprite.texels = (unsigned int*)stbi_load(argv[arg], &sprite.size.x, &sprite.size.y, &channels, 4);
+        SM_ASSERT_GUARD(sprite.texels, -1, "Failed to load %s", argv[arg]);
+        packer->sprites.add(sprite);
+    }
+
+    if(!pack_sprites(packer)) return -1;
+    if(!write_pages(packer, pagePrefix, &storage)) return -1;
+    FILE* out = begin_file_replace(outputPath);
+    if(!out) return -1;
+    if(!finish_file_replace(out, outputPath, write_atlas_header(packer, baseAtlasPath, pagePrefix, out))) return -1;
+    remove_stale_pages(packer, pagePrefix);
+    SM_TRACE("%d sprites on %d pages -> %s", packer->sprites.count, packer->pages.count, outputPath);
+    return 0;
+}
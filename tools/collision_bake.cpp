@@ -0,0 +1,137 @@
+#include "../src/assets.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+//#####################################################################################################################################
+//                                                  Collision Bake Constants
+//#####################################################################################################################################
+constexpr int COLLISION_ALPHA_THRESHOLD = 128;  // texels at least this opaque are solid
+constexpr int MAX_BAKE_MASKS = 4096;
+
+//#####################################################################################################################################
+//                                                  Collision Bake Structs
+//#####################################################################################################################################
+struct BakePage{
+    IVec2 size;
+    unsigned int* texels;
+};
+
+struct BakeMask{
+    IVec2 size;
+    int wordsPerRow;
+    int firstWord;
+    char label[32];
+};
+
+struct CollisionBaker{
+    FILE* out;
+    BakePage pages[ATLAS_PAGE_COUNT];
+    Array<BakeMask, MAX_BAKE_MASKS> masks;
+    int wordCount;
+};
+
+//#####################################################################################################################################
+//                                                  Collision Bake Functions
+//#####################################################################################################################################
+// Writes the rows of one mask into COLLISION_MASK_WORDS, texels outside the page count as transparent
+bool bake_mask(CollisionBaker* baker, IVec2 atlasOffset, IVec2 spriteSize, int atlasPage, char* label){
+    SM_ASSERT_GUARD(atlasPage >= 0 && atlasPage < ATLAS_PAGE_COUNT, false, "%s is on page %d, there are %d", label, atlasPage, ATLAS_PAGE_COUNT);
+    SM_ASSERT_GUARD(!baker->masks.is_full(), false, "More than %d masks", MAX_BAKE_MASKS);
+    BakePage* page = &baker->pages[atlasPage];
+    BakeMask mask = {};
+    mask.size = spriteSize;
+    mask.wordsPerRow = (spriteSize.x + 63) / 64;
+    mask.firstWord = baker->wordCount;
+    snprintf(mask.label, sizeof(mask.label), "%s", label);
+
+    int solidCount = 0;
+    fprintf(baker->out, "    // %s\n", label);
+    for(int y = 0; y < spriteSize.y; y++){
+        fprintf(baker->out, "   ");
+        for(int word = 0; word < mask.wordsPerRow; word++){
+            unsigned long long bits = 0;
+            for(int bit = 0; bit < 64 && word * 64 + bit < spriteSize.x; bit++){
+                int texelX = atlasOffset.x + word * 64 + bit;
+                int texelY = atlasOffset.y + y;
+                if(texelX < 0 || texelY < 0 || texelX >= page->size.x || texelY >= page->size.y) continue;
+                if((int)(page->texels[texelY * page->size.x + texelX] >> 24) < COLLISION_ALPHA_THRESHOLD) continue;
+                bits |= 1ull << bit;
+                solidCount++;
+            }
+            fprintf(baker->out, " 0x%016llxull,", bits);
+        }
+        fprintf(baker->out, "\n");
+    }
+    baker->wordCount += mask.wordsPerRow * spriteSize.y;
+    baker->masks.add(mask);
+    SM_TRACE("%s: %dx%d, %d solid pixels", label, spriteSize.x, spriteSize.y, solidCount);
+    return true;
+}
+
+void write_mask_table(CollisionBaker* baker, const char* name, const char* countName, int firstMask, int maskCount){
+    fprintf(baker->out, "constexpr CollisionMask %s[(%s > 0 ? %s : 1)] = {\n", name, countName, countName);
+    for(int idx = firstMask; idx < firstMask + maskCount; idx++){
+        BakeMask mask = baker->masks[idx];
+        fprintf(baker->out, "    {{%d, %d}, %d, %d},      // %s\n", mask.size.x, mask.size.y, mask.wordsPerRow, mask.firstWord, mask.label);
+    }
+    if(!maskCount) fprintf(baker->out, "    {},\n");
+    fprintf(baker->out, "};\n");
+}
+
+bool write_collision_header(CollisionBaker* baker){
+    fprintf(baker->out, "#pragma once\n");
+    fprintf(baker->out, "// Generated by tools/collision_bake.cpp from the alpha of the atlas pages, edit the sprites instead\n\n");
+    fprintf(baker->out, "constexpr unsigned long long COLLISION_MASK_WORDS[] = {\n");
+
+    char label[32];
+    int animationFrameCount = sizeof(ANIMATION_FRAMES) / sizeof(ANIMATION_FRAMES[0]);
+    for(int idx = 0; idx < SPRITE_COUNT; idx++){
+        snprintf(label, sizeof(label), "SpriteID %d", idx);
+        if(!bake_mask(baker, SPRITES[idx].atlasOffset, SPRITES[idx].spriteSize, SPRITES[idx].atlasPage, label)) return false;
+    }
+    for(int idx = 0; idx < PACKED_SPRITE_COUNT; idx++){
+        snprintf(label, sizeof(label), "PackedSpriteID %d", idx);
+        if(!bake_mask(baker, PACKED_SPRITES[idx].atlasOffset, PACKED_SPRITES[idx].spriteSize, PACKED_SPRITES[idx].atlasPage, label)) return false;
+    }
+    for(int idx = 0; idx < animationFrameCount; idx++){
+        snprintf(label, sizeof(label), "ANIMATION_FRAMES[%d]", idx);
+        AnimationFrame frame = ANIMATION_FRAMES[idx];
+        if(!bake_mask(baker, frame.atlasOffset, frame.spriteSize, frame.atlasPage, label)) return false;
+    }
+    if(!baker->wordCount) fprintf(baker->out, "    0,\n");
+    fprintf(baker->out, "};\n\n");
+
+    fprintf(baker->out, "constexpr int ANIMATION_FRAME_COUNT = %d;\n\n", animationFrameCount);
+    write_mask_table(baker, "SPRITE_COLLISION_MASKS", "SPRITE_COUNT", 0, SPRITE_COUNT);
+    fprintf(baker->out, "\n");
+    write_mask_table(baker, "PACKED_SPRITE_COLLISION_MASKS", "PACKED_SPRITE_COUNT", SPRITE_COUNT, PACKED_SPRITE_COUNT);
+    fprintf(baker->out, "\n");
+    write_mask_table(baker, "ANIMATION_FRAME_COLLISION_MASKS", "ANIMATION_FRAME_COUNT", (int)SPRITE_COUNT + PACKED_SPRITE_COUNT, animationFrameCount);
+    return true;
+}
+
+//#####################################################################################################################################
+//                                                  Collision Bake Main
+//#####################################################################################################################################
+// collision_bake.exe output.h
+// Bakes a 1 bit mask from the alpha of every sprite, packed sprite and animation frame rectangle on the atlas pages.
+// Has to run after aseprite_import.exe and atlas_pack.exe, it is built against the tables they write
+int main(int argc, char** argv){
+    SM_ASSERT_GUARD(argc >= 2, -1, "Usage: collision_bake.exe output.h");
+    char* outputPath = argv[1];
+
+    CollisionBaker baker = {};
+    for(int pageIdx = 0; pageIdx < ATLAS_PAGE_COUNT; pageIdx++){
+        BakePage* page = &baker.pages[pageIdx];
+        int channels;
+        page->texels = (unsigned int*)stbi_load(ATLAS_PAGES[pageIdx], &page->size.x, &page->size.y, &channels, 4);
+        SM_ASSERT_GUARD(page->texels, -1, "Failed to load %s", ATLAS_PAGES[pageIdx]);
+    }
+
+    baker.out = begin_file_replace(outputPath);
+    if(!baker.out) return -1;
+    if(!finish_file_replace(baker.out, outputPath, write_collision_header(&baker))) return -1;
+    SM_TRACE("%d masks, %d words -> %s", baker.masks.count, baker.wordCount, outputPath);
+    return 0;
+}